@@ -0,0 +1,46 @@
+/**
+ * @file bytebuf.h
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Tableau d'octets qui grandit.
+ *
+ * Octets ajoutés à la fin d'un tableau dont la place double quand il est
+ * plein : n ajouts coûtent O(n) copies en tout. Sert au bytecode et à la
+ * lnotab (parse.c) et au fichier .pyc (pyc.c).
+ */
+
+#ifndef _BYTEBUF_H_
+#define _BYTEBUF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+  struct bytebuf {
+    char   *data;
+    size_t  size;     /* octets écrits    */
+    size_t  capacity; /* place dans data  */
+  };
+
+  /* Tableau vide avec la place de 'capacity' octets (0 : alloué au
+     premier ajout), quand la taille finale est connue ou estimée */
+  void  bytebuf_init( struct bytebuf *buf, size_t capacity );
+
+  /* Place pour 'n' octets de plus sans nouvelle allocation */
+  void  bytebuf_reserve( struct bytebuf *buf, size_t n );
+
+  void  bytebuf_put( struct bytebuf *buf, const void *bytes, size_t n );
+  void  bytebuf_put_byte( struct bytebuf *buf, int byte );
+
+  /* Rend le tableau (à libérer par free), suivi d'un '\0' non compté
+     dans *size ; buf est vide ensuite */
+  char *bytebuf_release( struct bytebuf *buf, size_t *size );
+
+  void  bytebuf_free( struct bytebuf *buf );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BYTEBUF_H_ */
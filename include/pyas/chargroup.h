@@ -13,13 +13,20 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
+
+// Opérateurs, regroupés dans l'octet 'flags' du chargroup
+#define CHARGROUP_STAR     0x01 // '*'
+#define CHARGROUP_PLUS     0x02 // '+'
+#define CHARGROUP_QUESTION 0x04 // '?'
+#define CHARGROUP_NEGATION 0x08 // '^'
+
+#define CHARGROUP_WORDS 4 // 4 mots de 64 bits : un bit par octet (0 à 255)
+
 // @TODO Faire un type opaque...
 struct chargroup {
-  char set[128]; // ou char set[256] . Un tableau de booléen indexé par un caractère
-  int has_star_operator; // booléen. Vrai si operateur * activé. A NOTER : à faire évoluer plus tard !
-  int has_plus_operator;
-  int has_question_operator;
-  int has_negation; // '^'
+  uint64_t set[CHARGROUP_WORDS]; // ensemble de bits indexé par un octet : le bit c%64 du mot c/64
+  unsigned char flags;           // combinaison de CHARGROUP_STAR, _PLUS, _QUESTION, _NEGATION
 };
 
 typedef struct chargroup * chargroup_t;
@@ -38,9 +45,8 @@ void chargroup_delete(chargroup_t cg);
 // PRECONDITION cg != NULL
 void chargroup_print(chargroup_t cg);
 
-// Ajoute le caractère de code ASCII c dans le chargroup cg
+// Ajoute le caractère de code c (vu comme un octet 0 à 255) dans le chargroup cg
 // PRECONDITION cg != NULL
-// PRECONDITION : 0<=c
 void chargroup_add_char(chargroup_t cg, char c);
 
 // Ajoute tous les caractères (ASCII 0 à 128) du chargroup cg
@@ -48,9 +54,8 @@ void chargroup_add_char(chargroup_t cg, char c);
 // (utile pour l'opérateur point ".")
 void chargroup_add_all_chars(chargroup_t cg);
 
-// Retourne "vrai" (1) si le caractère c est dans le chargroup, "faux" (0) sinon
+// Retourne "vrai" (1) si le caractère c (vu comme un octet) est dans le chargroup, "faux" (0) sinon
 // PRECONDITION cg != NULL
-// PRECONDITION : 0<=c
 int chargroup_has_char(chargroup_t cg, char c);
 
 // Allume l'opérateur * ("zero or more")
@@ -75,21 +80,54 @@ int chargroup_delete_cb(void * cg);
 // Fonction "callback" d'affichage d'un groupe de caractères
 int chargroup_print_cb(void * cg);
 
-// Met le code ASCI de l'opérateur + à 1
+// Allume l'opérateur + ("one or more")
 void chargroup_set_operator_plus(chargroup_t cg);
 
-// Vérifie que le chargroup possède l'opérateur + en analysant les 128 caractères ASCI, retourne 1 ou 0
+// Vérifie que le chargroup possède l'opérateur +, retourne 1 ou 0
 int chargroup_has_operator_plus(chargroup_t cg);
 
-// Met le code ASCI de l'opérateur ? à 1
+// Allume l'opérateur ? ("zero or one")
 void chargroup_set_operator_question(chargroup_t cg);
 
-// Vérifie que le chargroup possède l'opérateur ? en analysant les 128 caractères ASCI, retourne 1 ou 0
+// Vérifie que le chargroup possède l'opérateur ?, retourne 1 ou 0
 int chargroup_has_operator_question(chargroup_t cg);
 
 // Vérifie que le chargroup n'est pas vide 
 int chargroup_not_empty(chargroup_t cg);
 
+// Allume la négation '^' ("one not in")
+// PRECONDITION cg != NULL
+void chargroup_set_negation(chargroup_t cg);
+
+// Retourne 1 si la négation '^' est activée dans le chargroup cg, 0 sinon
+// PRECONDITION cg != NULL
+int chargroup_has_negation(chargroup_t cg);
+
+////////
+// Opérations ensemblistes, mot par mot (4 mots de 64 bits).
+// Seuls les ensembles de caractères sont touchés, pas les opérateurs de dst.
+// dst peut être égal à a ou b.
+////////
+
+// dst = a U b
+void chargroup_union(chargroup_t dst, chargroup_t a, chargroup_t b);
+
+// dst = a inter b
+void chargroup_intersection(chargroup_t dst, chargroup_t a, chargroup_t b);
+
+// dst = a privé de b
+void chargroup_difference(chargroup_t dst, chargroup_t a, chargroup_t b);
+
+// dst = complémentaire de a sur les 256 octets
+void chargroup_complement(chargroup_t dst, chargroup_t a);
+
+// Retourne 1 si les ensembles de caractères de a et b sont égaux, 0 sinon
+int chargroup_equal(chargroup_t a, chargroup_t b);
+
+// Ensemble des octets réellement acceptés par cg : son ensemble, ou son
+// complémentaire s'il a la négation ('\0', fin de la source, n'y est jamais)
+void chargroup_accepted(chargroup_t dst, chargroup_t cg);
+
 #ifdef __cplusplus
 }
 #endif
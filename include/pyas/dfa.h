@@ -0,0 +1,85 @@
+/**
+ * @file dfa.h
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Automate déterministe des définitions de lexèmes.
+ *
+ * Compile une table de regexp (listes de chargroup_t renvoyées par
+ * re_read) en un unique automate déterministe.
+ */
+
+#ifndef _DFA_H_
+#define _DFA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pyas/list.h>
+
+  /* Option de dfa_new(), à combiner avec RE_MATCH_GREEDY ou RE_MATCH_NFA */
+#define DFA_LONGEST 0x10 /* plus long match parmi toutes les regexp, l'ordre départage les égalités */
+
+  /* Type opaque, défini dans src/dfa.c */
+  typedef struct dfa *dfa_t;
+
+  /*
+    Compile les 'count' regexp de 'regexps' en un seul automate.
+    Les entrées NULL (regexp invalide) ne matchent jamais.
+    'flags' choisit la sémantique de chaque regexp comme re_match_flags :
+    RE_MATCH_GREEDY (celle de re_match) ou RE_MATCH_NFA (plus long match).
+    Comme dans lex(), la première regexp qui matche gagne, sauf avec
+    DFA_LONGEST où le match le plus long gagne.
+  */
+  dfa_t dfa_new( list_t *regexps, int count, int flags );
+  void  dfa_delete( dfa_t dfa );
+
+  /*
+    Renvoie l'indice de la regexp retenue pour le début de 'source'
+    (et met à jour *end comme re_match), ou -1 si aucune ne matche.
+  */
+  int   dfa_match( dfa_t dfa, char *source, char **end );
+
+  /*
+    Comme dfa_match, et *stop désigne le dernier octet lu : celui sur
+    lequel l'automate s'est arrêté. Le '\0' final arrête toujours
+    l'automate ; si c'est lui, le résultat peut changer avec la suite
+    du texte (lecture par blocs, voir lexer_next).
+  */
+  int   dfa_match_stop( dfa_t dfa, char *source, char **end, char **stop );
+
+  int   dfa_state_count( dfa_t dfa );
+
+  /*
+    Tables d'un automate compilé : de quoi le générer en C à la
+    compilation (lexgen.exe) et le reconstruire sans rien recompiler.
+  */
+  struct dfa_tables {
+    int                  nclasses;
+    int                  nstates;
+    const unsigned char *classes; /* 256 : octet -> classe                            */
+    const int           *trans;   /* 2 * nstates * nclasses : état suivant (-1 : fin),
+                                     définition terminée avant l'octet (-1 : aucune) */
+    const int           *accept;  /* nstates : définition terminée en entrant (-1)    */
+
+    /* Mots-clés (hachage parfait), nslots == 0 s'il n'y en a pas */
+    int                  nbuckets;
+    int                  nslots;
+    int                  words_size;
+    const int           *buckets; /* nbuckets : graine du second hachage              */
+    const int           *slots;   /* 2 * nslots : définition (-1 : vide), position du
+                                     mot dans words                                   */
+    const char          *words;   /* words_size : mots terminés par '\0'              */
+  };
+
+  /* Remplit 'tables' avec des pointeurs vers les tables de 'dfa' */
+  void  dfa_tables( dfa_t dfa, struct dfa_tables *tables );
+
+  /* Automate utilisant directement les tables (non copiées, non libérées
+     par dfa_delete) : elles doivent vivre plus longtemps que lui */
+  dfa_t dfa_from_tables( const struct dfa_tables *tables );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DFA_H_ */
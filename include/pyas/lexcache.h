@@ -0,0 +1,49 @@
+/**
+ * @file lexcache.h
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Cache binaire de la table des lexèmes compilée.
+ *
+ * La table des lexèmes compilée (types, chargroup_t et opérateurs de
+ * chaque regexp, automate) est écrite dans un fichier à côté du fichier
+ * de définitions, puis relue par mmap aux exécutions suivantes.
+ */
+
+#ifndef _LEXCACHE_H_
+#define _LEXCACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pyas/list.h>
+#include <pyas/dfa.h>
+
+  /* Type opaque, défini dans src/lexcache.c */
+  typedef struct lexcache *lexcache_t;
+
+  /*
+    Charge le cache de 'regexp_file' pour les options LEX_NFA et
+    LEX_LONGEST de 'flags' ("<regexp_file>.<flags>.cache", un fichier par
+    jeu d'options). S'il n'existe pas ou si le contenu de regexp_file a
+    changé (empreinte du fichier), la table est recompilée et le cache
+    réécrit. Renvoie NULL si regexp_file ne peut pas être lu.
+  */
+  lexcache_t lexcache_open( char *regexp_file, int flags );
+  void       lexcache_close( lexcache_t cache );
+
+  /* Nombre de définitions, et type des lexèmes de chacune */
+  int        lexcache_count( lexcache_t cache );
+  char     **lexcache_types( lexcache_t cache );
+
+  /* Automate des définitions, valide jusqu'à lexcache_close() */
+  dfa_t      lexcache_dfa( lexcache_t cache );
+
+  /* Liste de lexdef_t reconstruite depuis le cache, sans re_read() :
+     même résultat que list_of_defintions() */
+  list_t     lexcache_definitions( lexcache_t cache );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LEXCACHE_H_ */
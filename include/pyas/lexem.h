@@ -13,18 +13,23 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <pyas/list.h> 
+#include <pyas/dfa.h>
 
   /*
-    This is called a 'forward declaration': the actual definition of  a
-    'struct lexem' is in lexem.c:16, and we only manipulate pointers to
-    such lexem structures (observe the star in the typedef). This makes
+    This is called a 'forward declaration': we only manipulate pointers
+    to lexem structures (observe the star in the typedef). This makes
     the definition of functions using this type legit, because pointers
     have all the same size.
   */
 
   typedef struct lexem *lexem_t;
   typedef struct lexdef *lexdef_t;
+  typedef struct lexarray *lexarray_t;
+  typedef struct lexer *lexer_t;
 
   /*
     The end goal is to hide the definition to the user, so as to force
@@ -36,17 +41,156 @@ extern "C" {
     This is the exactly the same technique that is used in the Standard
     Library with the FILE* type: you do not want to know what's inside,
     you only need using fopen, fclose and friends to manipulate files.
+
+    As with FILE in most libc headers, the definition of 'struct lexem'
+    is nevertheless given below, only so that the caller can provide the
+    storage of a lexeme read from a lexarray (lexarray_get and friends):
+    its fields are private, use the functions.
   */
 
+  struct lexsource;
+  struct lexarray;
+
+  struct lexem {
+    struct lexsource *source; /* NULL : lexème de lexem_new, type et valeur copiés */
+    char  *type;
+    char  *value;   /* lexème vue : copie faite au premier lexem_value(), dans source->values */
+    size_t offset;  /* lexème vue : position et longueur dans source->text */
+    size_t length;
+    uint64_t kinds; /* catégories LX_* du type : bit (1 << kind) */
+    int    type_id; /* lexème vue : indice de la définition */
+    int    line;    /* Start at line 1 ; lexème vue : 0 tant que pas demandée */
+    int    column;  /* Start at column 0 */
+    const struct lexarray *array; /* lexème lu dans un tableau, NULL sinon   */
+    unsigned generation;          /* du tableau à la lecture (voir lexarray) */
+  };
+
   /* Constructor */
   lexem_t lexem_new( char *type, char *value, int line, int column );
   char *file_to_string(char *source_file);
   list_t list_of_defintions(char *regexp_file);
+  lexdef_t lexdef_new( char *type, char *regexp_str, list_t regexp_list );
   list_t lex(char *regexp_file, char *source_file);
 
+  /* Options de lex_flags() */
+#define LEX_DEFAULT 0x00
+#define LEX_NFA     0x01 /* définitions au sens de l'automate de Thompson (RE_MATCH_NFA) */
+#define LEX_LONGEST 0x02 /* plus long lexème ("maximal munch"), l'ordre du fichier départage les égalités */
+#define LEX_CACHE   0x04 /* table compilée relue depuis "<regexp_file>.<flags>.cache" (voir lexcache.h) */
+#define LEX_INTERP  0x08 /* sans automate : re_match sur les définitions candidates pour le premier octet */
+#define LEX_NO_TRIVIA 0x10 /* commentaires et blancs retirés des lexèmes (rangés à part par lex_array) */
+#define LEX_PARALLEL  0x20 /* grosse source coupée aux fins de ligne et découpée par plusieurs threads */
+
+  list_t lex_flags(char *regexp_file, char *source_file, int flags);
+
+  /* LEX_PARALLEL : taille minimale d'un morceau en octets et nombre
+     maximal de threads, pour tous les découpages suivants (0 : 1 Mo, et
+     un thread par processeur) */
+  void lex_parallel_options(size_t chunk, int threads);
+
+  /* Découpe source_file avec un automate déjà compilé, types[i] étant le
+     type des lexèmes de la définition i */
+  list_t lex_dfa(dfa_t dfa, char **types, char *source_file);
+
+  /* Lexer compilé à l'avance par lexgen.exe ('make lexer=static') :
+     aucune regexp n'est lue ni compilée à l'exécution */
+  list_t lex_static(char *source_file);
+
+  /*
+    Mêmes lexers, les lexèmes rangés à la suite dans un tableau plutôt
+    qu'une liste : lexarray_get() y accède par indice, et tout est libéré
+    d'un coup par lexarray_delete(). Les lexem_t du tableau ne doivent
+    pas être passés à lexem_delete().
+    Le tableau ne garde que la position, la longueur et le type de chaque
+    lexème : lexarray_get, lexarray_trivia et lexarray_peek en font un
+    lexème complet dans la struct lexem fournie par l'appelant, et la
+    renvoient. Ce lexème reste valide jusqu'à ce que le tableau soit
+    modifié (lexarray_edit) ou, avec lex_stream, que sa fenêtre soit
+    vidée ou agrandie ; les fonctions lexem_*() le vérifient (assert).
+  */
+  lexarray_t lex_array(char *regexp_file, char *source_file, int flags);
+  lexarray_t lex_array_dfa(dfa_t dfa, char **types, char *source_file, int flags);
+  lexarray_t lex_static_array(char *source_file);
+
+  /*
+    Lexer par blocs, pour les sources de toute taille : le fichier est lu
+    au fur et à mesure et seule la partie non consommée est en mémoire.
+    lexer_next() renvoie le lexème suivant (à libérer par lexem_delete),
+    NULL à la fin du fichier ou sur une erreur lexicale ou de lecture
+    (lexer_error).
+    Toujours avec un automate : LEX_INTERP est ignoré.
+  */
+  lexer_t lexer_open(char *regexp_file, char *source_file, int flags);
+  lexer_t lexer_open_dfa(dfa_t dfa, char **types, char *source_file, int flags); /* dfa doit survivre au lexer */
+  lexer_t lexer_static(char *source_file, int flags);
+  lexem_t lexer_next(lexer_t lexer);
+  int     lexer_error(lexer_t lexer);
+  void    lexer_close(lexer_t lexer);
+
+  /* Tableau rempli par 'lexer' au fil de la lecture (il le ferme à sa
+     libération) : seuls les lexèmes pas encore consommés y restent */
+  lexarray_t lex_stream(lexer_t lexer);
+
+  void    lexarray_delete( lexarray_t lexems );
+  list_t  lexarray_list( lexarray_t lexems ); /* liste de lexem_t, libère le tableau */
+  size_t  lexarray_length( lexarray_t lexems );
+  lexem_t lexarray_get( lexarray_t lexems, size_t i, struct lexem *lex ); /* NULL après le dernier */
+
+  /*
+    Re-lexe après le remplacement des 'deleted' octets à la position
+    'offset' de la source par les 'length' octets de 'text' : seuls les
+    lexèmes autour de la modification sont refaits, les suivants sont
+    décalés. 'dfa' doit être l'automate qui a produit 'lexems' (lexèmes
+    de lex_array sans LEX_NO_TRIVIA, ou de lex_array_dfa). Renvoie le
+    nombre de lexèmes refaits, ou -1 (tableau inchangé) sur une erreur.
+    Les lexem_t et valeurs obtenus avant l'appel ne sont plus valides.
+  */
+  int     lexarray_edit( lexarray_t lexems, dfa_t dfa, size_t offset, size_t deleted, const char *text, size_t length );
+
+  /* Avec LEX_NO_TRIVIA : commentaires et blancs dans l'ordre de la source
+     (vide pour lex_stream, dont le lexer les saute) */
+  size_t  lexarray_trivia_length( lexarray_t lexems );
+  lexem_t lexarray_trivia( lexarray_t lexems, size_t i, struct lexem *lex );
+
+  /* Lecture par le parser : lexème courant, commentaires et blancs
+     sautés (NULL à la fin), puis passage au suivant */
+  lexem_t lexarray_peek( lexarray_t lexems, struct lexem *lex );
+  void    lexarray_advance( lexarray_t lexems );
+  int     lexarray_next_is( lexarray_t lexems, int kind );
+
+  /* Nombre de lexèmes de chaque catégorie kinds[k] dans counts[k], à
+     partir du lexème courant et jusqu'au premier de catégorie 'stop', en
+     un seul parcours. Avec lex_stream, seuls LEXARRAY_LOOKAHEAD lexèmes
+     sont lus d'avance : au-delà, les nombres sont des minorants */
+#define LEXARRAY_LOOKAHEAD 4096
+  void    lexarray_count( lexarray_t lexems, int stop, int nkinds, const int *kinds, size_t *counts );
+
   lexem_t lexem_peek( list_t *lexems );
   lexem_t lexem_advance( list_t *lexems );
   int next_lexem_is( list_t *lexems, char *type );
+
+  /*
+    Catégories de lexèmes testées par le parser. Un type appartient à
+    une catégorie si son nom commence par celui de la catégorie, comme
+    avec lexem_type() : "insn::1::64" est LX_INSN et LX_INSN_1. Chaque
+    type reçoit son masque de catégories une fois pour toutes au
+    chargement des définitions, le test n'est plus qu'un ET binaire.
+  */
+  enum lexem_kind {
+    LX_COMMENT, LX_BLANK, LX_NEWLINE, LX_COLON,
+    LX_PAREN_LEFT, LX_PAREN_RIGHT, LX_BRACK_LEFT, LX_BRACK_RIGHT,
+    LX_PYCST, LX_PYCST_NONE, LX_PYCST_TRUE, LX_PYCST_FALSE,
+    LX_INTEGER, LX_INTEGER_HEX, LX_INTEGER_DEC, LX_FLOAT, LX_STRING,
+    LX_VERSION_PYVM, LX_FLAGS, LX_FILENAME, LX_NAME, LX_STACK_SIZE, LX_ARG_COUNT,
+    LX_DIR, LX_DIR_SET, LX_DIR_INTERNED, LX_DIR_CONSTS, LX_DIR_NAMES,
+    LX_DIR_VARNAMES, LX_DIR_FREEVARS, LX_DIR_CELLVARS, LX_DIR_TEXT,
+    LX_DIR_LINE, LX_DIR_CODE_START, LX_DIR_CODE_END,
+    LX_INSN, LX_INSN_0, LX_INSN_1, LX_SYMBOL,
+    LX_KINDS /* nombre de catégories (au plus 64) */
+  };
+
+  int lexem_is( lexem_t lex, int kind );
+  int next_lexem_is_kind( list_t *lexems, int kind );
   int strict_next_lexem_is( list_t *lexems, char *type );
 
 
@@ -54,12 +198,24 @@ extern "C" {
   int     lexem_print( void *_lex );
   int     lexdef_print( void *_lexdef);
   int     lexem_delete( void *_lex );
+  int     lexdef_delete( void *_lexdef );
 
   int     lexem_type_strict( lexem_t lex, char *type );
   int     lexem_type( lexem_t lex, char *type );
   char *lexem_value( lexem_t lexem );
+  char *lexem_typename( lexem_t lex ); /* type de sa définition, ex. "insn::1::100" */
+  /* Texte du lexème dans la source, sans copie ni '\0' final */
+  const char *lexem_text( lexem_t lex, size_t *length );
+  /* Position du lexème : retrouvée au premier appel dans l'index des fins
+     de ligne de la source (construit une seule fois), pas pendant lex() */
   int     lexem_line( lexem_t lex );
   int     lexem_col( lexem_t lex );
+  int     lexem_opcode( lexem_t lex ); /* lexème insn::* : son opcode, -1 sinon */
+  int     lexem_arity( lexem_t lex );  /* lexème insn::* : nombre d'opérandes   */
+
+  char   *lexdef_type( lexdef_t lexdef );
+  list_t  lexdef_regexp( lexdef_t lexdef );
+  char   *lexdef_regexp_str( lexdef_t lexdef );
 
 #ifdef __cplusplus
 }
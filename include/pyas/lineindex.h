@@ -0,0 +1,38 @@
+/**
+ * @file lineindex.h
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Index des fins de ligne d'un texte.
+ *
+ * Les positions des '\n' d'un texte, relevées en un seul parcours
+ * vectorisé (AVX2 ou SSE2 selon le processeur, à défaut memchr), pour
+ * retrouver la ligne et la colonne d'un octet par dichotomie.
+ */
+
+#ifndef _LINEINDEX_H_
+#define _LINEINDEX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+  /*
+    Positions des '\n' des 'size' premiers octets de 'text', dans un
+    tableau alloué (à libérer par free) rangé dans *newlines. Renvoie leur
+    nombre.
+  */
+  size_t lineindex_new( const char *text, size_t size, size_t **newlines );
+
+  /*
+    Ligne (à partir de 1) et colonne (à partir de 0) de l'octet 'offset',
+    comme les compte lex() : la colonne est le nombre d'octets depuis le
+    dernier '\n'.
+  */
+  void   lineindex_position( const size_t *newlines, size_t count, size_t offset, int *line, int *column );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LINEINDEX_H_ */
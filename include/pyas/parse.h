@@ -14,11 +14,11 @@ extern "C" {
 #endif
 
 #include <pyas/list.h> 
+#include <pyas/lexem.h>
 
   /*
-    This is called a 'forward declaration': the actual definition of  a
-    'struct lexem' is in lexem.c:16, and we only manipulate pointers to
-    such lexem structures (observe the star in the typedef). This makes
+    This is called a 'forward declaration': we only manipulate pointers
+    to pyobj structures (observe the star in the typedef). This makes
     the definition of functions using this type legit, because pointers
     have all the same size.
   */
@@ -41,7 +41,7 @@ extern "C" {
 
   /* Constructor */
   void free_pyobj(pyobj_t obj);
-  pyobj_t parse(list_t *lexems);
+  pyobj_t parse(lexarray_t lexems);
   void print_pyobj(pyobj_t obj);
 
 #ifdef __cplusplus
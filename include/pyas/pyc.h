@@ -0,0 +1,39 @@
+/**
+ * @file pyc.h
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Écriture des fichiers .pyc.
+ *
+ * Sérialise l'arbre renvoyé par parse() au format marshal de Python 2.7
+ * (version 2), précédé de l'en-tête des .pyc.
+ */
+
+#ifndef _PYC_H_
+#define _PYC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <time.h>
+
+#include <pyas/parse.h>
+
+  /*
+    Fichier .pyc de l'objet code 'code' (racine renvoyée par parse()),
+    dans un tableau alloué (à libérer par free) de *size octets.
+    'timestamp' est la date de modification du source, écrite dans
+    l'en-tête. Une chaîne est écrite comme internée ('t' puis 'R') si
+    elle figure dans la directive .interned du module.
+  */
+  unsigned char *pyc_marshal( pyobj_t code, time_t timestamp, size_t *size );
+
+  /* Écrit ce fichier dans 'filename', en un seul appel à write().
+     Renvoie 0, ou -1 en cas d'erreur */
+  int            pyc_write( pyobj_t code, char *filename, time_t timestamp );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PYC_H_ */
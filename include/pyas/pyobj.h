@@ -0,0 +1,153 @@
+/**
+ * @file pyobj.h
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Objets Python construits par parse().
+ *
+ * Définition des pyobj_t et des py_codeblock, partagée par le parser
+ * (src/parse.c) et l'écriture des .pyc (src/pyc.c). Les programmes
+ * n'incluent que parse.h et pyc.h, où pyobj_t reste opaque.
+ */
+
+#ifndef _PYOBJ_H_
+#define _PYOBJ_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <time.h>
+#include <stdint.h>
+#include <pyas/parse.h>
+
+/* Structures de données (rappel, simplifiées) */
+
+#define NULL_MARKER           '0'  // Absence d’objet
+#define NONE_MARKER           'N'  // None
+#define FALSE_MARKER          'F'  // False
+#define TRUE_MARKER           'T'  // True
+#define INT_MARKER            'i'  // Entier signé sur 4 octets
+#define INT64_MARKER          'I'  // Entier signé sur 8 octets (plus généré)
+#define FLOAT_MARKER          'f'  // Chaîne d’un réel (max : 17 caractères)
+#define BINARY_FLOAT_MARKER   'g'  // Réel binaire sur 8 octets (double)
+#define COMPLEX_MARKER        'x'  // Deux chaînes pour un complexe
+#define BINARY_COMPLEX_MARKER 'y'  // Deux réels pour un complexe
+#define STRING_MARKER         's'  // Chaîne
+#define STRINGREF_MARKER      'R'  // Référence à une chaîne internée
+#define TUPLE_MARKER          '('  // Tuple
+#define LIST_MARKER           '['  // Liste
+#define DICT_MARKER           '{'  // Dictionnaire
+#define SET_MARKER            '<'  // Ensemble
+#define CODE_MARKER           'c'  // Objet de code
+#define STOP_ITER_MARKER      'S'  // Arrêt d’un itérateur
+#define ELLIPSIS_MARKER       '.'  // ...
+#define LONG_MARKER           'l'  // Entier signé en base 15
+#define UNICODE_MARKER        'u'  // Chaîne Unicode
+#define INTERNED_MARKER       't'  // Chaîne Unicode internée
+#define UNKNOWN_MARKER        '?'  // Objet de type inconnu
+#define FROZENSET_MARKER      '>'  // Ensemble en lecture seule
+
+#define OPTIMIZED               0x0001  // Optimisation active
+#define NEWLOCALS               0x0002  // Création d’un nouvel espace local de variables
+#define VARARGS                 0x0004  // Fonction acceptant des arguments variables (*args)
+#define VARKEYWORDS             0x0008  // Fonction acceptant des arguments mots-clés (**kwargs)
+#define NESTED                  0x0010  // Fonction imbriquée
+#define GENERATOR               0x0020  // Fonction génératrice
+#define NOFREE                  0x0040  // Pas de variables libres
+#define COROUTINE               0x0080  // Fonction coroutine
+#define ITERABLE_COROUTINE      0x0100  // Coroutine itérable
+#define ASYNC_GENERATOR         0x0200  // Générateur asynchrone
+#define FUTURE_DIVISION         0x20000 // Division avec comportement Python 3 (/ pour float, // pour int)
+#define FUTURE_ABSOLUTE_IMPORT  0x40000 // Importations absolues par défaut
+#define FUTURE_WITH_STATEMENT   0x80000 // Utilisation du "with"
+#define FUTURE_PRINT_FUNCTION   0x100000 // Utilisation de "print()" comme fonction
+#define FUTURE_UNICODE_LITERALS 0x200000 // Les littéraux sont des chaînes Unicode par défaut
+#define FUTURE_BARRY_AS_BDFL    0x400000 // Fonctionnalité humoristique "BARRY"
+#define FUTURE_GENERATOR_STOP   0x800000 // Stop itérateur sur la fin du générateur (évite StopIteration)
+#define FUTURE_ANNOTATIONS      0x1000000 // Support des annotations différées (PEP 563)
+
+typedef unsigned int pyobj_type ;
+
+/* Déclaration avant usage */
+struct py_codeblock;
+
+/* Structure globale pyobj_t */
+struct pyobj {
+    pyobj_type type;
+    unsigned int refcount;
+
+    union {
+        /* Pour stocker des sous-champs sous forme de liste de pyobj_t */
+        struct {
+            pyobj_t *value;
+            int size;
+            int capacity; /* place allouée dans value */
+        } list;
+
+        /* Pour stocker une chaîne : 'length' octets, '\0' compris
+           (bytecode), suivis d'un '\0' de plus */
+        struct {
+            char *buffer;
+            int length;
+        } string;
+
+        /* Pour stocker un bloc de code complet (champ unique) */
+        struct py_codeblock *codeblock;
+
+        /* Pour stocker un nombre, etc. */
+        union {
+            int integer;
+            int64_t integer64;
+            double real;
+            struct {
+                double real;
+                double imag;
+            } complex;
+        } number;
+
+    } py;
+};
+
+/* Codeblock : structure utilisée dans le champ union->codeblock */
+
+typedef struct py_codeblock {
+    int version_pyvm;
+    struct {
+        int arg_count;
+        int local_count;
+        int stack_size;
+        int flags;
+    } header;
+
+    pyobj_t parent; // non-géré ici
+
+    struct {
+        struct {
+            int magic;       // cst
+            time_t timestamp;// à ajouter
+            int source_size;
+        } header;
+
+        struct {
+            pyobj_t interned;
+            pyobj_t bytecode; // contiendra le « code »
+            pyobj_t consts;
+            pyobj_t names; 
+            pyobj_t varnames; 
+            pyobj_t freevars;
+            pyobj_t cellvars;
+        } content;
+
+        struct {
+            pyobj_t filename;
+            pyobj_t name;
+            int firstlineno; 
+            pyobj_t lnotab;
+        } trailer;
+    } binary;
+} py_codeblock;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PYOBJ_H_ */
@@ -10,7 +10,24 @@ extern "C" {
 #include <pyas/chargroup.h>
 
 
+// Moteurs de re_match_flags()
+#define RE_MATCH_GREEDY 0x00 // opérateurs gloutons, sans retour arrière (re_match)
+#define RE_MATCH_NFA    0x01 // simulation d'automate de Thompson : plus long préfixe qui matche
+
 int re_match( list_t re, char *source, char **end );
+int re_match_flags( list_t re, char *source, char **end, int flags );
+
+// Résultat de re_match_batch pour une chaîne
+typedef struct {
+  int    match; // 1 si le début de la chaîne matche
+  size_t end;   // longueur du préfixe reconnu (si match)
+} re_result_t;
+
+// Matche la même regexp (déjà lue par re_read) contre 'count' chaînes,
+// results[i] correspondant à sources[i]. Le travail est réparti sur
+// 'threads' threads (0 ou 1 : dans le thread appelant). Renvoie le
+// nombre de chaînes qui matchent.
+size_t re_match_batch( list_t re, char **sources, size_t count, re_result_t *results, int flags, int threads );
 
 #ifdef __cplusplus
 }
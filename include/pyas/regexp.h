@@ -16,18 +16,47 @@ extern "C" {
 #include <pyas/list.h> 
 #include <pyas/chargroup.h>
 
+  // Codes d'erreur de re_compile()
+#define RE_OK             0
+#define RE_ERR_OPERATOR   1 // opérateur en tête, ou opérateurs spéciaux consécutifs
+#define RE_ERR_WHITESPACE 2 // '\t' ou '\n' non échappé
+#define RE_ERR_NEGATION   3 // '^' en fin de chaîne
+#define RE_ERR_CLASS      4 // classe '[...]' mal formée
+#define RE_ERR_ESCAPE     5 // '\' en fin de chaîne
+
+  // Erreur de compilation d'une regexp
+  typedef struct {
+    int  code;          // RE_OK ou RE_ERR_*
+    int  index;         // position dans la regexp, -1 si aucune
+    char message[160];  // message lisible, celui qu'affiche re_read()
+  } re_error_t;
+
+  // État de lecture d'une regexp : un contexte par thread, rien de caché
+  // entre deux appels (re_compile peut tourner en parallèle)
+  typedef struct {
+    int        prev_type; // dernier début de groupe : 0 normal, 1 opérateur, 2 '^'
+    re_error_t error;     // première erreur rencontrée
+  } re_context_t;
+
+  void re_context_init(re_context_t *ctx);
+
+  // Comme re_read, sans rien afficher : renvoie NULL et remplit ctx->error
+  // en cas d'erreur
+  list_t re_compile(re_context_t *ctx, const char* regexp_str);
+
   //Lire une expression régulière “simplifiée” et la convertir en liste de chargroup_t.
+  // Les erreurs sont affichées sur stderr.
   list_t re_read(char* regexp_str);
 
 
   // affiche une expression régulière encodé sous la forme d'une liste de chargroup_t
   void re_print(list_t re);
   // Vérifie que la syntaxe des opérateurs est correcte ("Erreur: opérateurs spéciaux consécutifs ou invalides à l'index)
-  int check_special_operators(const char* regexp_str, int idx);
+  int check_special_operators(re_context_t *ctx, const char* regexp_str, int idx);
   //  Parse jusqu'à la fermeture ']', gère les intervalles x-y, refuse +, *, ?, ^ s'ils ne sont pas échappés,et autorise (a\-z) => "a", "-", "z".   
-  int parse_char_class(const char* regexp_str, int* idx_ptr, chargroup_t cg);
+  int parse_char_class(re_context_t *ctx, const char* regexp_str, int* idx_ptr, chargroup_t cg);
   //  Gère \n, \t, et sinon ajoute le caractère littéral.
-  int parse_escape_sequence(const char* regexp_str, int* idx_ptr, chargroup_t cg);
+  int parse_escape_sequence(re_context_t *ctx, const char* regexp_str, int* idx_ptr, chargroup_t cg);
   //  Retourne 1 si un opérateur est lu, 0 sinon
   int parse_operator(const char* regexp_str, int* idx_ptr, chargroup_t cg);
 
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <pyas/lexem.h>
+#include <pyas/parse.h>
+#include <pyas/pyc.h>
+
+int main(int argc, char *argv[]) {
+    // Option : --timestamp N, date du source écrite dans l'en-tête du .pyc
+    // (par défaut celle du fichier .pys)
+    long timestamp = -1;
+    if (argc > 2 && !strcmp(argv[1], "--timestamp")) {
+        timestamp = atol(argv[2]);
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s [--timestamp N] <source.pys> <sortie.pyc>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (timestamp < 0) {
+        struct stat st;
+        if (stat(argv[1], &st)) {
+            fprintf(stderr, "Erreur: impossible de lire '%s'.\n", argv[1]);
+            exit(EXIT_FAILURE);
+        }
+        timestamp = (long)st.st_mtime;
+    }
+
+    // Même lecture que parser.exe : lexèmes à la demande, sans commentaires ni blancs
+#ifdef STATIC_LEXER
+    lexer_t lexer = lexer_static(argv[1], LEX_NO_TRIVIA);
+#else
+    lexer_t lexer = lexer_open("regexp_file.txt", argv[1], LEX_CACHE | LEX_NO_TRIVIA);
+#endif
+    if( NULL == lexer ) exit(EXIT_FAILURE);
+    lexarray_t lexems = lex_stream(lexer);
+    pyobj_t code = parse(lexems);
+    int error = lexer_error(lexer);
+    lexarray_delete(lexems);
+    if( NULL == code || error ) exit(EXIT_FAILURE);
+
+    error = pyc_write(code, argv[2], (time_t)timestamp);
+    free_pyobj(code);
+
+    exit(error ? EXIT_FAILURE : EXIT_SUCCESS);
+}
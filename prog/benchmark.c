@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include <unitest/clock.h>
+#include <pyas/list.h>
+#include <pyas/lexem.h>
+#include <pyas/dfa.h>
+#include <pyas/re_match.h>
+#include <pyas/parse.h>
+
+/*
+  Mesure séparément, pour chaque source :
+    - list_of_defintions() : lecture et compilation des regexp,
+    - dfa_new()            : construction de l'automate,
+    - lex                  : découpage de la source (lex_array_dfa),
+    - parse()              : construction de l'arbre à partir des lexèmes.
+  Chaque mesure est la meilleure de --repeat passes. Les débits sont
+  donnés en Mo/s et en lexèmes/s, et la mémoire en pic de RSS du
+  processus (un processus par source pour qu'il ne mesure qu'elle).
+*/
+
+static double best(double t, double best_t)
+{
+    return best_t < 0 || t < best_t ? t : best_t;
+}
+
+static void print_rate(const char *what, double nsec, double mb, size_t lexems)
+{
+    printf("  %-20s %10.2f ms", what, nsec / 1e6);
+    if (mb > 0) printf("  %9.2f Mo/s  %12.0f lexèmes/s", mb / (nsec / 1e9), lexems / (nsec / 1e9));
+    printf("\n");
+}
+
+static long peak_rss_kb(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; /* octets sous macOS */
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    int flags = LEX_DEFAULT;
+    int repeat = 3;
+
+    // Options : --nfa et --longest (automate), --no-trivia, --parallel (lex),
+    // --repeat N (meilleure de N passes)
+    while (argc > 1 && !strncmp(argv[1], "--", 2)) {
+        if (!strcmp(argv[1], "--nfa")) flags |= LEX_NFA;
+        else if (!strcmp(argv[1], "--longest")) flags |= LEX_LONGEST;
+        else if (!strcmp(argv[1], "--no-trivia")) flags |= LEX_NO_TRIVIA;
+        else if (!strcmp(argv[1], "--parallel")) flags |= LEX_PARALLEL;
+        else if (!strcmp(argv[1], "--repeat") && argc > 2 && atoi(argv[2]) > 0) {
+            repeat = atoi(argv[2]);
+            argv++;
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Option inconnue: %s\n", argv[1]);
+            exit(EXIT_FAILURE);
+        }
+        argv++;
+        argc--;
+    }
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s [--nfa] [--longest] [--no-trivia] [--parallel] [--repeat N] <regexp_file> <source>...\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // Définitions et automate
+    double t_defs = -1, t_dfa = -1;
+    list_t defs = NULL;
+    dfa_t dfa = NULL;
+    for (int r = 0; r < repeat; r++) {
+        list_delete(defs, lexdef_delete);
+        dfa_delete(dfa);
+
+        elapsed_nsec();
+        defs = list_of_defintions(argv[1]);
+        t_defs = best(elapsed_nsec(), t_defs);
+        if (!defs) {
+            fprintf(stderr, "Erreur: Aucune définition de lexèmes chargée depuis '%s'.\n", argv[1]);
+            exit(EXIT_FAILURE);
+        }
+
+        int ndefs = (int)list_length(defs);
+        list_t *regexps = calloc(ndefs, sizeof(*regexps));
+        if (!regexps) {
+            fprintf(stderr, "Erreur d'allocation mémoire pour la table des définitions.\n");
+            exit(EXIT_FAILURE);
+        }
+        int k = 0;
+        for (list_t l = defs; !list_is_empty(l); l = list_next(l)) regexps[k++] = lexdef_regexp(list_first(l));
+
+        elapsed_nsec();
+        dfa = dfa_new(regexps, ndefs, ((flags & LEX_NFA) ? RE_MATCH_NFA : RE_MATCH_GREEDY)
+                                    | ((flags & LEX_LONGEST) ? DFA_LONGEST : 0));
+        t_dfa = best(elapsed_nsec(), t_dfa);
+        free(regexps);
+    }
+
+    int ndefs = (int)list_length(defs);
+    char **types = calloc(ndefs + 1, sizeof(*types));
+    int k = 0;
+    for (list_t l = defs; !list_is_empty(l); l = list_next(l)) types[k++] = lexdef_type(list_first(l));
+
+    printf("%s : %d définitions, %d états\n", argv[1], ndefs, dfa_state_count(dfa));
+    print_rate("list_of_defintions", t_defs, 0, 0);
+    print_rate("dfa_new", t_dfa, 0, 0);
+
+    int status = EXIT_SUCCESS;
+    for (int i = 2; i < argc; i++) {
+        struct stat st;
+        if (stat(argv[i], &st)) {
+            fprintf(stderr, "Erreur: impossible de lire '%s'.\n", argv[i]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+        double mb = st.st_size / (1024. * 1024.);
+        double t_lex = -1, t_parse = -1;
+        size_t count = 0, parsed = 0;
+        int failed = 0;
+
+        for (int r = 0; r < repeat && !failed; r++) {
+            elapsed_nsec();
+            lexarray_t lexems = lex_array_dfa(dfa, types, argv[i], flags);
+            t_lex = best(elapsed_nsec(), t_lex);
+            if (!lexems) {
+                failed = 1;
+                break;
+            }
+            count  = lexarray_length(lexems) + lexarray_trivia_length(lexems);
+            parsed = lexarray_length(lexems);
+
+            elapsed_nsec();
+            pyobj_t ast = parse(lexems);
+            t_parse = best(elapsed_nsec(), t_parse);
+            if (!ast) failed = 1;
+            free_pyobj(ast);
+            lexarray_delete(lexems);
+        }
+
+        printf("%s : %.2f Mo, %zu lexèmes\n", argv[i], mb, count);
+        if (t_lex >= 0) print_rate("lex", t_lex, mb, count);
+        if (failed) {
+            printf("  %-20s échec\n", t_parse < 0 ? "lex" : "parse");
+            status = EXIT_FAILURE;
+        }
+        else print_rate("parse", t_parse, mb, parsed);
+    }
+    printf("  %-20s %10.2f Mo\n", "RSS max", peak_rss_kb() / 1024.);
+
+    free(types);
+    dfa_delete(dfa);
+    list_delete(defs, lexdef_delete);
+
+    exit(status);
+}
@@ -1,19 +1,209 @@
+#include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <pyas/list.h>
 #include <pyas/lexem.h>
 #include <pyas/regexp.h>
+#include <pyas/dfa.h>
+#include <pyas/re_match.h>
+
+/* Modification de --edit : "position,longueur,texte", avec \n, \t et \\ décodés dans le texte */
+static int edit_parse(char *arg, size_t *offset, size_t *deleted, char **text, size_t *length)
+{
+    char *comma1 = strchr(arg, ',');
+    char *comma2 = comma1 ? strchr(comma1 + 1, ',') : NULL;
+    if (!comma2) return 0;
+    *offset = strtoul(arg, NULL, 10);
+    *deleted = strtoul(comma1 + 1, NULL, 10);
+    *text = comma2 + 1;
+
+    char *out = *text;
+    for (char *in = *text; *in; in++) {
+        if (*in == '\\' && in[1]) {
+            in++;
+            *out++ = *in == 'n' ? '\n' : *in == 't' ? '\t' : *in;
+        }
+        else *out++ = *in;
+    }
+    *length = out - *text;
+    return 1;
+}
+
+/*
+  --edit : lexarray_edit() sur les lexèmes de 'source_file', comparés à
+  ceux du texte modifié découpé en entier. Affiche les lexèmes obtenus ;
+  renvoie EXIT_FAILURE s'ils diffèrent (type, texte, ligne ou colonne).
+*/
+static int edit_check(char *regexp_file, char *source_file, int flags, char *edit)
+{
+    size_t offset, deleted, length;
+    char *text;
+    if (!edit_parse(edit, &offset, &deleted, &text, &length)) {
+        fprintf(stderr, "Erreur: --edit attend position,longueur,texte.\n");
+        return EXIT_FAILURE;
+    }
+
+    list_t defs = list_of_defintions(regexp_file);
+    int ndefs = (int)list_length(defs);
+    if (!ndefs) return EXIT_FAILURE;
+    list_t *regexps = calloc(ndefs, sizeof(*regexps));
+    char **types = calloc(ndefs + 1, sizeof(*types));
+    assert(regexps && types);
+    int k = 0;
+    for (list_t l = defs; !list_is_empty(l); l = list_next(l), k++) {
+        regexps[k] = lexdef_regexp(list_first(l));
+        types[k] = lexdef_type(list_first(l));
+    }
+    dfa_t dfa = dfa_new(regexps, ndefs, ((flags & LEX_NFA) ? RE_MATCH_NFA : RE_MATCH_GREEDY)
+                                      | ((flags & LEX_LONGEST) ? DFA_LONGEST : 0));
+    free(regexps);
+
+    int status = EXIT_FAILURE;
+    char *source = file_to_string(source_file);
+    lexarray_t lexems = source ? lex_array_dfa(dfa, types, source_file, flags) : NULL;
+    size_t size = source ? strlen(source) : 0;
+    if (lexems && (offset > size || deleted > size - offset))
+        fprintf(stderr, "Erreur: modification hors de la source (%zu octets).\n", size);
+    else if (lexems) {
+        /* Texte modifié, découpé en entier pour comparer */
+        char path[] = "/tmp/lexer-edit-XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0
+         || write(fd, source, offset) != (ssize_t)offset
+         || write(fd, text, length) != (ssize_t)length
+         || write(fd, source + offset + deleted, size - offset - deleted) != (ssize_t)(size - offset - deleted)) {
+            fprintf(stderr, "Erreur: impossible d'écrire le texte modifié dans '%s'.\n", path);
+        }
+        else {
+            int redone = lexarray_edit(lexems, dfa, offset, deleted, text, length);
+            lexarray_t full = lex_array_dfa(dfa, types, path, flags);
+
+            if (redone < 0 || !full) {
+                /* Erreur lexicale : elle doit l'être des deux côtés */
+                if (redone < 0 && !full) status = EXIT_SUCCESS;
+                else fprintf(stderr, "Erreur: lexarray_edit %s, le découpage complet %s.\n",
+                             redone < 0 ? "échoue" : "réussit", full ? "réussit" : "échoue");
+            }
+            else {
+                size_t n = lexarray_length(lexems), i = 0;
+                if (n != lexarray_length(full))
+                    fprintf(stderr, "Erreur: %zu lexèmes après lexarray_edit, %zu en découpage complet.\n", n, lexarray_length(full));
+                else for (; i < n; i++) {
+                    struct lexem lex_a, lex_b;
+                    lexem_t a = lexarray_get(lexems, i, &lex_a), b = lexarray_get(full, i, &lex_b);
+                    size_t la, lb;
+                    const char *ta = lexem_text(a, &la), *tb = lexem_text(b, &lb);
+                    if (strcmp(lexem_typename(a), lexem_typename(b)) || la != lb || memcmp(ta, tb, la)
+                     || lexem_line(a) != lexem_line(b) || lexem_col(a) != lexem_col(b)) {
+                        fprintf(stderr, "Erreur: lexème %zu différent du découpage complet : ", i);
+                        fflush(stderr);
+                        lexem_print(a);
+                        printf(" au lieu de ");
+                        lexem_print(b);
+                        printf("\n");
+                        break;
+                    }
+                }
+                if (i == n && n == lexarray_length(full)) {
+                    list_t list = lexarray_list(lexems);
+                    lexems = NULL;
+                    list_print(list, lexem_print);
+                    list_delete(list, lexem_delete);
+                    fprintf(stderr, "lexarray_edit : %d lexèmes refaits, comme le découpage complet.\n", redone);
+                    status = EXIT_SUCCESS;
+                }
+            }
+            lexarray_delete(full);
+        }
+        if (fd >= 0) {
+            close(fd);
+            unlink(path);
+        }
+    }
+
+    lexarray_delete(lexems);
+    free(source);
+    dfa_delete(dfa);
+    free(types);
+    list_delete(defs, lexdef_delete);
+    return status;
+}
 
 int main(int argc, char *argv[])
 {
+    int flags = LEX_DEFAULT;
+
+    // Options : --nfa (automate de Thompson), --longest (plus long lexème),
+    // --cache (table compilée relue depuis <regexp_file>.<flags>.cache),
+    // --interp (re_match sur les candidates du premier octet, sans automate),
+    // --stream (lecture par blocs avec lexer_next, lexèmes affichés au fil de l'eau),
+    // --no-trivia (sans commentaires ni blancs), --parallel (plusieurs threads sur une grosse source),
+    // --edit position,longueur,texte (lexarray_edit vérifié par un découpage complet)
+    // Avec --parallel, LEX_PARALLEL_CHUNK (taille minimale d'un morceau) et
+    // LEX_PARALLEL_THREADS (nombre maximal de threads) permettent de le faire
+    // tourner sur de petites sources
+    int stream = 0;
+    char *edit = NULL;
+    while (argc > 1 && !strncmp(argv[1], "--", 2)) {
+        if (!strcmp(argv[1], "--nfa")) flags |= LEX_NFA;
+        else if (!strcmp(argv[1], "--longest")) flags |= LEX_LONGEST;
+        else if (!strcmp(argv[1], "--cache")) flags |= LEX_CACHE;
+        else if (!strcmp(argv[1], "--interp")) flags |= LEX_INTERP;
+        else if (!strcmp(argv[1], "--stream")) stream = 1;
+        else if (!strcmp(argv[1], "--no-trivia")) flags |= LEX_NO_TRIVIA;
+        else if (!strcmp(argv[1], "--parallel")) flags |= LEX_PARALLEL;
+        else if (!strcmp(argv[1], "--edit") && argc > 2) {
+            edit = argv[2];
+            argv++;
+            argc--;
+        }
+        else {
+            fprintf(stderr, "Option inconnue: %s\n", argv[1]);
+            exit(EXIT_FAILURE);
+        }
+        argv++;
+        argc--;
+    }
+
     // Vérifie que le programme a reçu exactement 3 argument
     if (argc != 3) {
-        fprintf(stderr, "Usage: %s <lexer>\n", argv[0]);
+        fprintf(stderr, "Usage: %s [--nfa] [--longest] [--cache] [--interp] [--stream] [--no-trivia] [--parallel] [--edit pos,len,texte] <regexp_file> <source>\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    list_t lex_list = lex(argv[1], argv[2]);
+    if (flags & LEX_PARALLEL) {
+        char *chunk = getenv("LEX_PARALLEL_CHUNK"), *threads = getenv("LEX_PARALLEL_THREADS");
+        long n = chunk ? strtol(chunk, NULL, 10) : 0;
+        lex_parallel_options(n > 0 ? (size_t)n : 0, threads ? atoi(threads) : 0);
+    }
+
+    if (edit) {
+        if (stream || (flags & (LEX_NO_TRIVIA | LEX_INTERP | LEX_CACHE))) {
+            fprintf(stderr, "Erreur: --edit découpe avec l'automate, sans --stream, --no-trivia, --interp ni --cache.\n");
+            exit(EXIT_FAILURE);
+        }
+        exit(edit_check(argv[1], argv[2], flags, edit));
+    }
+
+    if (stream) {
+        lexer_t lexer = lexer_open(argv[1], argv[2], flags);
+        if( NULL == lexer) exit(EXIT_FAILURE);
+        // Même affichage que list_print
+        printf("( ");
+        for (lexem_t lex; (lex = lexer_next(lexer)); lexem_delete(lex)) {
+            lexem_print(lex);
+            printf(" ");
+        }
+        printf(")");
+        int error = lexer_error(lexer);
+        lexer_close(lexer);
+        exit(error ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    list_t lex_list = lex_flags(argv[1], argv[2], flags);
     if( NULL == lex_list) exit(EXIT_FAILURE);
     list_print(lex_list, lexem_print);
 
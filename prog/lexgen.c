@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <pyas/list.h>
+#include <pyas/lexem.h>
+#include <pyas/re_match.h>
+#include <pyas/dfa.h>
+
+/*
+  Génère sur la sortie standard un lexer en C pour un fichier de
+  définitions : l'automate de lex_flags() y est écrit sous forme de
+  tables constantes, et lex_static() n'a plus qu'à le parcourir.
+*/
+
+// Écrit une chaîne C entre guillemets
+static void print_c_string(const char *s)
+{
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') printf("\\%c", *s);
+        else if ((unsigned char)*s < ' ' || (unsigned char)*s >= 127) printf("\\%03o", (unsigned char)*s);
+        else putchar(*s);
+    }
+    putchar('"');
+}
+
+// Écrit un tableau d'entiers, 16 par ligne
+static void print_ints(const char *decl, const int *values, int count)
+{
+    printf("%s = {", decl);
+    for (int i = 0; i < count; i++)
+        printf("%s%d%s", i % 16 ? " " : "\n  ", values[i], i + 1 < count ? "," : "");
+    printf("\n};\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int flags = LEX_DEFAULT;
+
+    // Options : les mêmes que lexer.exe
+    while (argc > 1 && !strncmp(argv[1], "--", 2)) {
+        if (!strcmp(argv[1], "--nfa")) flags |= LEX_NFA;
+        else if (!strcmp(argv[1], "--longest")) flags |= LEX_LONGEST;
+        else {
+            fprintf(stderr, "Option inconnue: %s\n", argv[1]);
+            exit(EXIT_FAILURE);
+        }
+        argv++;
+        argc--;
+    }
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s [--nfa] [--longest] <regexp_file> > lexer_tables.c\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    list_t defs = list_of_defintions(argv[1]);
+    if (!defs) {
+        fprintf(stderr, "Erreur: Aucune définition de lexèmes chargée depuis '%s'.\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    int ndefs = (int)list_length(defs);
+    list_t *regexps = calloc(ndefs + 1, sizeof(*regexps));
+    if (!regexps) {
+        fprintf(stderr, "Erreur d'allocation mémoire pour la table des définitions.\n");
+        exit(EXIT_FAILURE);
+    }
+    int k = 0;
+    for (list_t l = defs; !list_is_empty(l); l = list_next(l), k++)
+        regexps[k] = lexdef_regexp(list_first(l));
+
+    dfa_t dfa = dfa_new(regexps, ndefs, ((flags & LEX_NFA) ? RE_MATCH_NFA : RE_MATCH_GREEDY)
+                                       | ((flags & LEX_LONGEST) ? DFA_LONGEST : 0));
+    struct dfa_tables tables;
+    dfa_tables(dfa, &tables);
+
+    printf("/*\n"
+           "  Fichier généré par lexgen.exe à partir de '%s' : ne pas modifier.\n"
+           "  %d définitions, %d états, %d classes d'octets.\n"
+           "*/\n\n", argv[1], ndefs, tables.nstates, tables.nclasses);
+    printf("#include <stddef.h>\n\n"
+           "#include <pyas/lexem.h>\n"
+           "#include <pyas/dfa.h>\n\n");
+
+    printf("static char *types[] = {");
+    k = 0;
+    for (list_t l = defs; !list_is_empty(l); l = list_next(l), k++) {
+        printf("\n  ");
+        print_c_string(lexdef_type(list_first(l)));
+        printf("%s", k + 1 < ndefs ? "," : "");
+    }
+    printf(",\n  NULL\n};\n\n");
+
+    int classes[256];
+    for (int c = 0; c < 256; c++) classes[c] = tables.classes[c];
+    print_ints("static const unsigned char classes[256]", classes, 256);
+    print_ints("static const int trans[]", tables.trans, 2 * tables.nstates * tables.nclasses);
+    print_ints("static const int accept[]", tables.accept, tables.nstates);
+
+    // Mots-clés (hachage parfait)
+    if (tables.nslots) {
+        int *words = calloc(tables.words_size + 1, sizeof(*words));
+        for (int i = 0; i < tables.words_size; i++) words[i] = tables.words[i];
+        print_ints("static const int buckets[]", tables.buckets, tables.nbuckets);
+        print_ints("static const int slots[]", tables.slots, 2 * tables.nslots);
+        print_ints("static const char words[]", words, tables.words_size);
+        free(words);
+    }
+
+    printf("static const struct dfa_tables tables = {\n"
+           "  %d, %d, classes, trans, accept,\n"
+           "  %d, %d, %d, %s\n"
+           "};\n\n", tables.nclasses, tables.nstates,
+           tables.nbuckets, tables.nslots, tables.words_size,
+           tables.nslots ? "buckets, slots, words" : "NULL, NULL, NULL");
+
+    printf("lexarray_t lex_static_array(char *source_file) {\n"
+           "  dfa_t dfa = dfa_from_tables(&tables);\n"
+           "  lexarray_t lexems = lex_array_dfa(dfa, types, source_file, LEX_DEFAULT);\n"
+           "  dfa_delete(dfa);\n"
+           "  return lexems;\n"
+           "}\n\n"
+           "list_t lex_static(char *source_file) {\n"
+           "  return lexarray_list(lex_static_array(source_file));\n"
+           "}\n\n"
+           "lexer_t lexer_static(char *source_file, int flags) {\n"
+           "  static dfa_t dfa = NULL; /* gardé jusqu'à la fin du programme */\n"
+           "  if (!dfa) dfa = dfa_from_tables(&tables);\n"
+           "  return lexer_open_dfa(dfa, types, source_file, flags);\n"
+           "}\n");
+
+    dfa_delete(dfa);
+    free(regexps);
+    list_delete(defs, lexdef_delete);
+
+    exit(EXIT_SUCCESS);
+}
@@ -11,9 +11,19 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    list_t lexems = lex("regexp_file.txt", argv[1]);  // par exemple
-    pyobj_t ast = parse(&lexems);
-    if( NULL == ast ) exit(EXIT_FAILURE);
+    // Lexèmes lus à la demande du parser : la source n'est jamais entièrement en mémoire,
+    // et commentaires et blancs sont sautés par le lexer
+#ifdef STATIC_LEXER
+    lexer_t lexer = lexer_static(argv[1], LEX_NO_TRIVIA);  // tables générées par lexgen.exe
+#else
+    lexer_t lexer = lexer_open("regexp_file.txt", argv[1], LEX_CACHE | LEX_NO_TRIVIA);  // table relue depuis regexp_file.txt.0.cache
+#endif
+    if( NULL == lexer ) exit(EXIT_FAILURE);
+    lexarray_t lexems = lex_stream(lexer);
+    pyobj_t ast = parse(lexems);
+    int error = lexer_error(lexer);
+    lexarray_delete(lexems);
+    if( NULL == ast || error ) exit(EXIT_FAILURE);
     print_pyobj(ast);
 
     exit(EXIT_SUCCESS);
@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+/*
+  Génère sur la sortie standard un fichier .pys synthétique d'environ
+  <ko> kilo-octets, pour mesurer le lexer et le parser (benchmark.exe) :
+
+    insn     beaucoup d'instructions et de directives .line
+    consts   beaucoup de constantes (entiers, flottants, chaînes, tuples)
+    nested   des fonctions imbriquées (.code_start) sur NESTED_DEPTH niveaux
+    strings  de longues chaînes internées et de longs commentaires
+    wide     un module d'au moins WIDE_CONSTS constantes, dont il affiche
+             une d'indice au-delà de 0xFFFF (EXTENDED_ARG)
+    jumps    un module d'au moins JUMPS_LABELS étiquettes enchaînées et de
+             sauts au-delà de 0xFFFF (EXTENDED_ARG), qui affiche "ok"
+
+  Le module contient des fonctions de FUNC_SIZE octets environ (une
+  chaîne de fonctions imbriquées pour nested). Le texte est
+  pseudo-aléatoire mais toujours le même pour une taille donnée.
+*/
+
+#define FUNC_SIZE     (128 * 1024)
+#define NESTED_SIZE   (32 * 1024)
+#define MAX_FUNCS     1000
+#define NESTED_DEPTH  32
+#define MAX_ITEMS     1000
+#define WIDE_CONSTS   70001
+#define JUMPS_LABELS  30000
+
+static size_t written = 0;     /* octets écrits */
+static unsigned long seed = 1;
+
+static void out(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    if (n > 0) written += n;
+}
+
+static int rnd(int n)
+{
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    return (int)((seed >> 33) % n);
+}
+
+// Mot pseudo-aléatoire de 'n' lettres (chaînes et commentaires)
+static void out_word(int n)
+{
+    char buf[64];
+    if (n > (int)sizeof(buf) - 1) n = sizeof(buf) - 1;
+    for (int i = 0; i < n; i++) buf[i] = 'a' + rnd(26);
+    buf[n] = '\0';
+    out("%s", buf);
+}
+
+static void out_text(int length)
+{
+    for (int n = 0; n < length; n++) {
+        out_word(1 + rnd(10));
+        out(" ");
+        n += 10;
+    }
+}
+
+static void out_header(const char *name, int flags)
+{
+    out(".set version_pyvm\t 62211\n"
+        ".set flags\t\t 0x%08x\n"
+        ".set filename\t\t \"bench.py\"\n"
+        ".set name\t\t \"%s\"\n"
+        ".set stack_size\t\t 4\n"
+        ".set arg_count\t\t 0\n\n", flags, name);
+}
+
+// Corps d'une fonction de la forme 'shape', jusqu'à 'end' octets écrits
+static void out_function(const char *shape, int id, size_t end, int depth)
+{
+    char name[32];
+    size_t start = written;
+    snprintf(name, sizeof(name), "f%d_%d", id, depth);
+
+    out(".code_start %d\n", id + 1);
+    out_header(name, 0x43);
+
+    if (!strcmp(shape, "strings")) {
+        out(".interned\n");
+        for (int i = 0; i < MAX_ITEMS && written < start + (end - start) / 4 * 3; i++) {
+            out("\t\"");
+            out_text(100 + rnd(2000));
+            out("\"\n");
+            if (!rnd(4)) {
+                out("# ");
+                out_text(200 + rnd(2000));
+                out("\n");
+            }
+        }
+        out("\n");
+    }
+
+    out(".consts\n\tNone\n");
+    if (!strcmp(shape, "nested") && depth < NESTED_DEPTH)
+        out_function(shape, id, end, depth + 1);
+    if (!strcmp(shape, "consts")) {
+        for (int i = 1; i < MAX_ITEMS && written < start + (end - start) / 8 * 7; i++) {
+            switch (rnd(6)) {
+            case 0:  out("\t%d\n", rnd(1000000) - 500000); break;
+            case 1:  out("\t0x%x\n", rnd(1 << 30)); break;
+            case 2:  out("\t%d.%d\n", rnd(1000), rnd(1000)); break;
+            case 3:  out("\t%d.%de-%d\n", rnd(10), rnd(1000), rnd(30)); break;
+            case 4:  out("\t\""); out_word(1 + rnd(30)); out("\"\n"); break;
+            default: out("\t( %d \"", rnd(100)); out_word(4); out("\" None True %d.5 )\n", rnd(100)); break;
+            }
+        }
+    }
+    out("\n.names\n\t\"x\"\n\t\"y\"\n\n.text\n");
+
+    // Lignes après celle de la fonction (argument de .code_start)
+    int line = id + 2;
+    for (;;) {
+        out(".line %d\n", line++);
+        out("\tLOAD_NAME             0\t# \"x\"\n"
+            "\tLOAD_CONST            0\t# None\n"
+            "\tBINARY_ADD            ");
+        if (!strcmp(shape, "strings") && !rnd(2)) {
+            out("# ");
+            out_text(100 + rnd(1000));
+        }
+        out("\n\tSTORE_NAME            1\t# \"y\"\n");
+        if (written >= end) break;
+    }
+    out("\tLOAD_CONST            0\t# None\n"
+        "\tRETURN_VALUE          \n"
+        ".code_end\n");
+}
+
+// Module 'wide' : n entiers i * 3 puis None, et affiche la constante n - 2
+static void out_wide(size_t size)
+{
+    int n = (int)(size / 8) > WIDE_CONSTS ? (int)(size / 8) : WIDE_CONSTS;
+
+    out_header("<module>", 0x40);
+    out(".interned\n\t\"<module>\"\n\n.consts\n");
+    for (int i = 0; i < n; i++) out("\t%d\n", i * 3);
+    out("\tNone\n\n.text\n.line 1\n"
+        "\tLOAD_CONST            %d\n"
+        "\tPRINT_ITEM            \n"
+        "\tPRINT_NEWLINE         \n"
+        "\tLOAD_CONST            %d\t# None\n"
+        "\tRETURN_VALUE          \n", n - 2, n);
+}
+
+// Module 'jumps' : n sauts enchaînés (3 octets chacun) entre des sauts
+// absolus et relatifs, en avant et en arrière, par-dessus toute la chaîne
+static void out_jumps(size_t size)
+{
+    int n = (int)(size / 32) > JUMPS_LABELS ? (int)(size / 32) : JUMPS_LABELS;
+
+    out_header("<module>", 0x40);
+    out(".interned\n\t\"<module>\"\n\n.consts\n\tNone\n\t1\n\t\"ok\"\n\n.text\n.line 1\n"
+        "\tSETUP_LOOP            done\n"
+        "\tLOAD_CONST            1\n"
+        "\tPOP_JUMP_IF_FALSE     done\n"
+        "\tJUMP_FORWARD          j0\n");
+    for (int i = 0; i < n; i++) {
+        if (i % 1000 == 999) out(".line %d\n", 2 + i / 1000);
+        out("j%d:\n\tJUMP_FORWARD          j%d\n", i, i + 1);
+    }
+    out("j%d:\n"
+        "\tJUMP_ABSOLUTE         tail\n"
+        "back:\n"
+        "\tPOP_BLOCK             \n"
+        "done:\n"
+        "\tLOAD_CONST            2\t# \"ok\"\n"
+        "\tPRINT_ITEM            \n"
+        "\tPRINT_NEWLINE         \n"
+        "\tLOAD_CONST            0\t# None\n"
+        "\tRETURN_VALUE          \n"
+        "tail:\n"
+        "\tJUMP_ABSOLUTE         back\n", n);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *shapes[] = { "insn", "consts", "nested", "strings", "wide", "jumps", NULL };
+    int known = 0;
+
+    if (argc == 3)
+        for (int i = 0; shapes[i]; i++) known |= !strcmp(argv[1], shapes[i]);
+    if (!known || atol(argv[2]) <= 0) {
+        fprintf(stderr, "Usage: %s <insn|consts|nested|strings|wide|jumps> <ko> > source.pys\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *shape = argv[1];
+    size_t size = (size_t)atol(argv[2]) * 1024;
+    out("# Fichier généré par pysgen.exe %s %s\n\n", argv[1], argv[2]);
+    if (!strcmp(shape, "wide")) {
+        out_wide(size);
+        exit(EXIT_SUCCESS);
+    }
+    if (!strcmp(shape, "jumps")) {
+        out_jumps(size);
+        exit(EXIT_SUCCESS);
+    }
+    int nfuncs = (int)(size / (strcmp(shape, "nested") ? FUNC_SIZE : NESTED_SIZE));
+    if (nfuncs < 1) nfuncs = 1;
+    if (nfuncs > MAX_FUNCS) nfuncs = MAX_FUNCS;
+    size_t func_size = size / nfuncs;
+
+    out_header("<module>", 0x40);
+    out(".interned\n");
+    for (int i = 0; i < nfuncs; i++) out("\t\"f%d_0\"\n", i);
+    out("\t\"<module>\"\n\n.consts\n");
+    for (int i = 0; i < nfuncs; i++) out_function(shape, i, written + func_size, 0);
+    out("\tNone\n\n.names\n");
+    for (int i = 0; i < nfuncs; i++) out("\t\"f%d_0\"\n", i);
+    out("\n.text\n.line 1\n");
+    for (int i = 0; i < nfuncs; i++)
+        out("\tLOAD_CONST            %d\n"
+            "\tMAKE_FUNCTION         0\n"
+            "\tSTORE_NAME            %d\t# \"f%d_0\"\n", i, i, i);
+    out("\tLOAD_CONST            %d\t# None\n"
+        "\tRETURN_VALUE          \n", nfuncs);
+
+    exit(EXIT_SUCCESS);
+}
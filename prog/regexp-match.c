@@ -9,6 +9,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <pyas/list.h>
 #include <pyas/re_match.h>
@@ -16,12 +17,106 @@
 #include <pyas/chargroup.h>
 
 
+/* Lit tout le flux et le découpe en lignes (les '\n' deviennent des '\0') */
+static char *read_lines( FILE *in, char ***lines, size_t *count ) {
+  size_t size = 0, capacity = 1 << 16, n = 0, nlines = 0;
+  char *buffer = malloc( capacity );
+
+  if ( !buffer ) return NULL;
+  while ( ( n = fread( buffer + size, 1, capacity - size - 1, in ) ) > 0 ) {
+    size += n;
+    if ( size + 1 == capacity ) {
+      char *bigger = realloc( buffer, 2 * capacity );
+      if ( !bigger ) {
+        free( buffer );
+        return NULL;
+      }
+      buffer = bigger;
+      capacity *= 2;
+    }
+  }
+  buffer[ size ] = '\0';
+
+  for ( size_t i = 0 ; i < size ; i++ ) nlines += '\n' == buffer[ i ];
+  if ( size > 0 && buffer[ size - 1 ] != '\n' ) nlines++; /* dernière ligne sans '\n' */
+
+  *lines = malloc( ( nlines + 1 ) * sizeof( **lines ) );
+  if ( !*lines ) {
+    free( buffer );
+    return NULL;
+  }
+  *count = 0;
+  for ( char *p = buffer ; *count < nlines ; p++ ) {
+    ( *lines )[ ( *count )++ ] = p;
+    p = strchr( p, '\n' );
+    if ( !p ) break;
+    *p = '\0';
+  }
+  return buffer;
+}
+
+/* Mode --batch : une regexp, une chaîne par ligne de 'input' (ou stdin),
+   une ligne "numéro match fin" par chaîne */
+static int match_batch( list_t re, char *input, int flags, int threads ) {
+  FILE *in = ( !input || !strcmp( input, "-" ) ) ? stdin : fopen( input, "r" );
+  char **lines = NULL;
+  size_t count = 0, matched;
+  re_result_t *results;
+  char *buffer;
+
+  if ( !in ) {
+    fprintf( stderr, "Erreur: impossible d'ouvrir '%s'.\n", input );
+    return EXIT_FAILURE;
+  }
+  buffer = read_lines( in, &lines, &count );
+  if ( in != stdin ) fclose( in );
+  results = calloc( count + 1, sizeof( *results ) );
+  if ( !buffer || !results ) {
+    fprintf( stderr, "Erreur d'allocation mémoire pour les chaînes à matcher.\n" );
+    return EXIT_FAILURE;
+  }
+
+  matched = re_match_batch( re, lines, count, results, flags, threads );
+
+  for ( size_t i = 0 ; i < count ; i++ ) {
+    if ( results[ i ].match ) printf( "%zu 1 %zu\n", i + 1, results[ i ].end );
+    else                      printf( "%zu 0 -\n", i + 1 );
+  }
+  fprintf( stderr, "%zu/%zu lignes matchent.\n", matched, count );
+
+  free( results );
+  free( lines );
+  free( buffer );
+  return EXIT_SUCCESS;
+}
+
 int main ( int argc, char *argv[] ) { 
   char     *end = NULL; 
   int  is_match; 
+  int  flags = RE_MATCH_GREEDY;
+  int  batch = 0, threads = 1;
+
+  /* --nfa : simulation d'automate de Thompson au lieu du moteur glouton
+     --batch : les chaînes sont les lignes d'un fichier (ou de stdin)
+     --jobs N : en mode --batch, répartir le travail sur N threads */
+  while ( argc > 1 && !strncmp( argv[ 1 ], "--", 2 ) ) {
+    if ( !strcmp( argv[ 1 ], "--nfa" ) ) flags = RE_MATCH_NFA;
+    else if ( !strcmp( argv[ 1 ], "--batch" ) ) batch = 1;
+    else if ( !strcmp( argv[ 1 ], "--jobs" ) && argc > 2 ) {
+      threads = atoi( argv[ 2 ] );
+      argv++;
+      argc--;
+    }
+    else {
+      fprintf( stderr, "Option inconnue: %s\n", argv[ 1 ] );
+      exit( EXIT_FAILURE );
+    }
+    argv++;
+    argc--;
+  }
 
-  if ( argc < 3 ) {
-    fprintf( stderr, "Usage :\n\t%s regexp text\n", argv[ 0 ] );
+  if ( argc < ( batch ? 2 : 3 ) ) {
+    fprintf( stderr, "Usage :\n\t%s [--nfa] regexp text\n\t%s [--nfa] --batch [--jobs N] regexp [file|-]\n", argv[ 0 ], argv[ 0 ] );
     exit( EXIT_FAILURE );
   }
 
@@ -31,7 +126,11 @@ int main ( int argc, char *argv[] ) {
     exit(1);
   }
 
-  is_match = re_match( re, argv[ 2 ], &end );
+  if ( batch ) {
+    exit( match_batch( re, argc > 2 ? argv[ 2 ] : NULL, flags, threads ) );
+  }
+
+  is_match = re_match_flags( re, argv[ 2 ], &end, flags );
 
   if ( is_match ) {
     printf( "The start of '%s' is %s, %s: '%s'.\n", argv[2], argv[ 1 ], *end ? "next" : "END", end );
@@ -0,0 +1,62 @@
+/**
+ * @file bytebuf.c
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Tableau d'octets qui grandit.
+ *
+ * La place double à chaque agrandissement, en gardant toujours un octet
+ * de plus pour le '\0' que bytebuf_release() ajoute sans recopier.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <pyas/bytebuf.h>
+
+#define BYTEBUF_MIN 64
+
+void bytebuf_init( struct bytebuf *buf, size_t capacity ) {
+  assert( buf );
+  buf->data     = NULL;
+  buf->size     = 0;
+  buf->capacity = 0;
+  if ( capacity ) bytebuf_reserve( buf, capacity );
+}
+
+void bytebuf_reserve( struct bytebuf *buf, size_t n ) {
+  size_t capacity = buf->capacity;
+
+  if ( buf->size + n < capacity ) return;
+  if ( !capacity ) capacity = n + 1 > BYTEBUF_MIN ? n + 1 : BYTEBUF_MIN;
+  while ( buf->size + n >= capacity ) capacity *= 2;
+  buf->data = realloc( buf->data, capacity );
+  assert( buf->data );
+  buf->capacity = capacity;
+}
+
+void bytebuf_put( struct bytebuf *buf, const void *bytes, size_t n ) {
+  bytebuf_reserve( buf, n );
+  memcpy( buf->data + buf->size, bytes, n );
+  buf->size += n;
+}
+
+void bytebuf_put_byte( struct bytebuf *buf, int byte ) {
+  if ( buf->size + 1 >= buf->capacity ) bytebuf_reserve( buf, 1 );
+  buf->data[ buf->size++ ] = (char)byte;
+}
+
+char *bytebuf_release( struct bytebuf *buf, size_t *size ) {
+  char *data;
+
+  bytebuf_reserve( buf, 0 );
+  data = buf->data;
+  data[ buf->size ] = '\0';
+  if ( size ) *size = buf->size;
+  bytebuf_init( buf, 0 );
+  return data;
+}
+
+void bytebuf_free( struct bytebuf *buf ) {
+  free( buf->data );
+  bytebuf_init( buf, 0 );
+}
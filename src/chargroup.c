@@ -30,12 +30,12 @@ void chargroup_delete(chargroup_t cg) {
 void chargroup_print(chargroup_t cg) {
   
   assert( NULL != cg );
-  if(cg->has_negation) 
+  if( chargroup_has_negation( cg ) ) 
     printf("One not in \"");
   else
     printf("One in \"");
   for(int i = 0 ; i < 128 ; i++) {
-    if( cg->set[i] ) {
+    if( chargroup_has_char( cg, i ) ) {
       if( isgraph( i ) ) {
         printf("%c", i);
       } else if(i == '\n') {
@@ -50,11 +50,11 @@ void chargroup_print(chargroup_t cg) {
     }
   }
   printf("\", ");
-  if( cg->has_star_operator ) {
+  if( chargroup_has_operator_star( cg ) ) {
     printf("zero or more times.");}
-  else if( cg->has_plus_operator ) {
+  else if( chargroup_has_operator_plus( cg ) ) {
     printf("one or more times.");}
-  else if( cg->has_question_operator ) {
+  else if( chargroup_has_operator_question( cg ) ) {
     printf("zero or one time.");}
   else {
     printf("one time.");
@@ -62,52 +62,62 @@ void chargroup_print(chargroup_t cg) {
 }
 
 void chargroup_add_char(chargroup_t cg, char c) {
+  unsigned char u = (unsigned char)c;
   assert( NULL != cg );
-  assert( c >= 0);
-  cg->set[ (int) c] = 1;
+  cg->set[ u >> 6 ] |= (uint64_t)1 << ( u & 63 );
 }
 
 void chargroup_add_all_chars(chargroup_t cg) {
   assert( NULL != cg );
-  for(int i = 0 ; i < 128 ; i++) {
-    cg->set[i] = 1;
-  }
+  // ASCII 0 à 127 : les deux premiers mots
+  cg->set[0] = ~(uint64_t)0;
+  cg->set[1] = ~(uint64_t)0;
 }
 
 int chargroup_has_char(chargroup_t cg, char c) {
+  unsigned char u = (unsigned char)c;
   assert( NULL != cg );
-  assert( c >= 0);
-  return cg->set[ (int)c ];
+  return ( cg->set[ u >> 6 ] >> ( u & 63 ) ) & 1;
 }
 
 void chargroup_set_operator_star(chargroup_t cg) {
   assert( NULL != cg );
-  cg->has_star_operator = 1;
+  cg->flags |= CHARGROUP_STAR;
 }
 
 int chargroup_has_operator_star(chargroup_t cg) {
   assert( NULL != cg );
-  return cg->has_star_operator;
+  return !!( cg->flags & CHARGROUP_STAR );
 }
 
 void chargroup_set_operator_plus(chargroup_t cg) {
   assert( NULL != cg );
-  cg->has_plus_operator = 1;
+  cg->flags |= CHARGROUP_PLUS;
 }
 
 int chargroup_has_operator_plus(chargroup_t cg) {
   assert( NULL != cg );
-  return cg->has_plus_operator;
+  return !!( cg->flags & CHARGROUP_PLUS );
 }
 
 void chargroup_set_operator_question(chargroup_t cg) {
   assert( NULL != cg );
-  cg->has_question_operator = 1;
+  cg->flags |= CHARGROUP_QUESTION;
 }
 
 int chargroup_has_operator_question(chargroup_t cg) {
   assert( NULL != cg );
-  return cg->has_question_operator;
+  return !!( cg->flags & CHARGROUP_QUESTION );
+}
+
+void chargroup_set_negation(chargroup_t cg) {
+  assert( NULL != cg );
+  cg->flags |= CHARGROUP_NEGATION;
+}
+
+int chargroup_has_negation(chargroup_t cg) {
+  assert( NULL != cg );
+  return !!( cg->flags & CHARGROUP_NEGATION );
 }
 
 
@@ -127,12 +137,44 @@ int chargroup_print_cb(void * cg) {
 
 
 int chargroup_not_empty(chargroup_t cg) {
-    // Vérifie qu'au moins un élément est non nul
+  // Vérifie qu'au moins un mot est non nul
+  assert( NULL != cg );
+  return ( cg->set[0] | cg->set[1] | cg->set[2] | cg->set[3] ) != 0;
+}
 
-    for (int i = 0; i < 128; i++) {
-        if (chargroup_has_char(cg, i)) {
-            return 1; // Au moins un élément est non nul
-        }
-    }
-    return 0; // Tous les éléments sont nuls
+// Les opérations ensemblistes travaillent mot par mot : 4 opérations
+// sur 64 bits (ou une seule instruction vectorielle si le compilateur
+// le souhaite) au lieu d'une boucle sur 256 octets.
+
+void chargroup_union(chargroup_t dst, chargroup_t a, chargroup_t b) {
+  assert( NULL != dst && NULL != a && NULL != b );
+  for (int w = 0; w < CHARGROUP_WORDS; w++) dst->set[w] = a->set[w] | b->set[w];
+}
+
+void chargroup_intersection(chargroup_t dst, chargroup_t a, chargroup_t b) {
+  assert( NULL != dst && NULL != a && NULL != b );
+  for (int w = 0; w < CHARGROUP_WORDS; w++) dst->set[w] = a->set[w] & b->set[w];
+}
+
+void chargroup_difference(chargroup_t dst, chargroup_t a, chargroup_t b) {
+  assert( NULL != dst && NULL != a && NULL != b );
+  for (int w = 0; w < CHARGROUP_WORDS; w++) dst->set[w] = a->set[w] & ~b->set[w];
+}
+
+void chargroup_complement(chargroup_t dst, chargroup_t a) {
+  assert( NULL != dst && NULL != a );
+  for (int w = 0; w < CHARGROUP_WORDS; w++) dst->set[w] = ~a->set[w];
+}
+
+int chargroup_equal(chargroup_t a, chargroup_t b) {
+  assert( NULL != a && NULL != b );
+  return ( ( a->set[0] ^ b->set[0] ) | ( a->set[1] ^ b->set[1] )
+         | ( a->set[2] ^ b->set[2] ) | ( a->set[3] ^ b->set[3] ) ) == 0;
+}
+
+void chargroup_accepted(chargroup_t dst, chargroup_t cg) {
+  assert( NULL != dst && NULL != cg );
+  if ( chargroup_has_negation( cg ) ) chargroup_complement( dst, cg );
+  else if ( dst != cg ) memcpy( dst->set, cg->set, sizeof( dst->set ) );
+  dst->set[0] &= ~(uint64_t)1; // '\0' marque la fin de la source
 }
\ No newline at end of file
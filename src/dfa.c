@@ -0,0 +1,857 @@
+/**
+ * @file dfa.c
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Automate déterministe des définitions de lexèmes.
+ *
+ * Construction par sous-ensembles d'un automate unique à partir de
+ * toutes les regexp de la table des lexèmes.
+ *
+ * Chaque regexp (suite de chargroup_t avec opérateurs gloutons) est déjà
+ * un automate déterministe : on est dans le groupe i, et le caractère
+ * courant décide seul s'il est consommé, si l'on passe au groupe suivant
+ * ou si le match échoue. Un "item" est donc la position (groupe, déjà
+ * consommé au moins une fois pour '+') dans une regexp, et un état de
+ * l'automate global est l'ensemble des items encore vivants.
+ *
+ * Pour garder la priorité "première définition qui matche" de lex(), un
+ * état mémorise aussi le seuil : l'indice de la meilleure définition déjà
+ * terminée. Les items de définitions d'indice supérieur ne peuvent plus
+ * gagner, on les élimine, ce qui arrête le parcours au plus tôt.
+ *
+ * Avec RE_MATCH_NFA, les items sont les états de l'automate de Thompson
+ * de chaque regexp (mêmes couples (groupe, drapeau '+'), mais plusieurs
+ * par définition), fermés par les transitions vides : une définition peut
+ * alors matcher à plusieurs longueurs et l'on garde la plus longue, comme
+ * re_match_flags().
+ *
+ * Avec DFA_LONGEST (plus long match, "maximal munch"), il n'y a plus de
+ * seuil : tous les items restent vivants tant qu'ils peuvent avancer, et
+ * dfa_match garde la dernière acceptation rencontrée. À longueur égale,
+ * l'acceptation d'un état ou d'une transition est la plus petite
+ * définition, donc l'ordre du fichier départage les ex aequo.
+ *
+ * Les définitions qui ne sont qu'un mot littéral (mnémoniques insn::*,
+ * directives .xxx, None...) sont aussi rangées dans une table de hachage
+ * parfaite : dfa_match lit le mot une fois, le cherche dans la table et
+ * ne parcourt l'automate que s'il n'y est pas. Un mot n'est retenu que
+ * si l'automate, une fois le mot lu, donne cette définition et s'arrête
+ * quel que soit l'octet suivant (hors lettres, chiffres et '_') : les
+ * deux chemins donnent alors toujours le même lexème.
+ *
+ * Enfin, un état qui boucle sur lui-même (commentaire après '#', chaîne
+ * après '"', suite de blancs ou de '\n') est parcouru par blocs de 16
+ * octets : on cherche le premier octet qui sort de la boucle, parmi
+ * quelques octets d'arrêt (RUN_UNTIL) ou hors de quelques octets
+ * répétés (RUN_WHILE), au lieu d'une transition par octet.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <pyas/dfa.h>
+#include <pyas/list.h>
+#include <pyas/chargroup.h>
+#include <pyas/re_match.h>
+
+#define OP_ONE      0
+#define OP_STAR     1
+#define OP_PLUS     2
+#define OP_QUESTION 3
+
+struct dfa_trans {
+  int next;   /* état suivant, -1 si plus rien ne peut matcher        */
+  int accept; /* définition terminée AVANT de consommer le caractère */
+};
+
+/* Boucle d'un état sur lui-même (voir dfa_runs) */
+#define RUN_NONE  0
+#define RUN_UNTIL 1 /* jusqu'au premier des octets 'bytes' ('\0' en fait partie) */
+#define RUN_WHILE 2 /* tant que l'octet est l'un des octets 'bytes'             */
+#define RUN_BYTES 4
+
+struct dfa_run {
+  int           kind;
+  int           nbytes;
+  unsigned char bytes[ RUN_BYTES ];
+};
+
+/* struct dfa_trans est rangée comme deux int consécutifs (dfa_tables) */
+typedef char dfa_trans_is_two_ints[ sizeof( struct dfa_trans ) == 2 * sizeof( int ) ? 1 : -1 ];
+
+struct dfa {
+  int                     nclasses;
+  unsigned char           classes[256]; /* octet -> classe d'équivalence  */
+  int                     nstates;
+  const struct dfa_trans *trans;        /* nstates * nclasses             */
+  const int              *accept;       /* définition terminée en entrant  */
+
+  /* Mots-clés : hachage parfait à deux niveaux (seau, puis case) */
+  int                     nbuckets;     /* puissance de 2                  */
+  int                     nslots;       /* puissance de 2, 0 : aucun mot   */
+  int                     words_size;
+  const int              *buckets;      /* graine du second hachage        */
+  const int              *slots;        /* 2 par case : définition (-1 :
+                                           vide), position dans words     */
+  const char             *words;        /* mots terminés par '\0'         */
+
+  struct dfa_run         *runs;         /* nstates : boucles parcourues par
+                                           blocs (toujours allouées)      */
+  int                     owned;        /* tables allouées par dfa_new     */
+};
+
+/* Regexp mises à plat pendant la construction */
+struct builder {
+  int             nfa;     /* sémantique RE_MATCH_NFA                   */
+  int             longest; /* DFA_LONGEST : pas de seuil de priorité    */
+  int             ndefs;
+  int             ngroups;
+  int            *op;      /* opérateur du groupe                       */
+  int            *def;     /* définition à laquelle appartient le groupe */
+  int            *end;     /* indice de fin de cette définition          */
+  struct chargroup *accepted; /* octets acceptés, négation appliquée     */
+
+  /* États : items triés + seuil + acceptation à l'entrée */
+  int             nstates;
+  int             capacity;
+  int           **items;
+  int            *nitems;
+  int            *threshold;
+  int            *accept;
+
+  int            *table;   /* table de hachage des états (indices)       */
+  int             table_size;
+
+  unsigned char  *seen;    /* items déjà ajoutés (mode RE_MATCH_NFA)    */
+};
+
+static void *xrealloc( void *ptr, size_t size ) {
+  void *p = realloc( ptr, size );
+  if ( NULL == p && size ) {
+    fprintf( stderr, "Erreur d'allocation mémoire dans la construction de l'automate.\n" );
+    exit( EXIT_FAILURE );
+  }
+  return p;
+}
+
+/* Aplatit les chargroup_t de toutes les regexp dans des tableaux */
+static void builder_load( struct builder *b, list_t *regexps, int count ) {
+  int total = 0;
+  for ( int d = 0 ; d < count ; d++ ) {
+    if ( NULL == regexps[ d ] ) continue;
+    for ( list_t l = regexps[ d ] ; !list_is_empty( l ) ; l = list_next( l ) )
+      total++;
+  }
+
+  b->ndefs   = count;
+  b->ngroups = 0;
+  b->op      = xrealloc( NULL, ( total + 1 ) * sizeof( int ) );
+  b->def     = xrealloc( NULL, ( total + 1 ) * sizeof( int ) );
+  b->end     = xrealloc( NULL, ( total + 1 ) * sizeof( int ) );
+  b->accepted = xrealloc( NULL, ( total + 1 ) * sizeof( *b->accepted ) );
+
+  for ( int d = 0 ; d < count ; d++ ) {
+    int first = b->ngroups;
+    if ( NULL == regexps[ d ] ) continue;
+    for ( list_t l = regexps[ d ] ; !list_is_empty( l ) ; l = list_next( l ) ) {
+      chargroup_t cg = list_first( l );
+      int g = b->ngroups++;
+
+      if ( NULL == cg ) { /* regexp vide : ne peut pas faire avancer lex() */
+        b->ngroups = first;
+        break;
+      }
+      if      ( chargroup_has_operator_star( cg ) )     b->op[ g ] = OP_STAR;
+      else if ( chargroup_has_operator_question( cg ) ) b->op[ g ] = OP_QUESTION;
+      else if ( chargroup_has_operator_plus( cg ) )     b->op[ g ] = OP_PLUS;
+      else                                              b->op[ g ] = OP_ONE;
+      b->def[ g ] = d;
+      chargroup_accepted( &b->accepted[ g ], cg );
+    }
+    for ( int g = first ; g < b->ngroups ; g++ ) b->end[ g ] = b->ngroups;
+  }
+}
+
+/*
+  Regroupe les octets qui se comportent de la même façon dans tous les
+  groupes : on part d'une seule classe (tous les octets) que chaque groupe
+  coupe en deux (intersection / différence) quand il la sépare.
+*/
+static void compute_classes( struct builder *b, struct dfa *dfa ) {
+  struct chargroup part[ 256 ];
+  int n = 1;
+
+  memset( part, 0, sizeof( part ) );
+  chargroup_complement( &part[ 0 ], &part[ 0 ] );
+
+  for ( int g = 0 ; g < b->ngroups ; g++ ) {
+    int m = n;
+    for ( int k = 0 ; k < m ; k++ ) {
+      struct chargroup in, out;
+      chargroup_intersection( &in, &part[ k ], &b->accepted[ g ] );
+      chargroup_difference( &out, &part[ k ], &b->accepted[ g ] );
+      if ( chargroup_not_empty( &in ) && chargroup_not_empty( &out ) ) {
+        part[ k ]   = in;
+        part[ n++ ] = out;
+      }
+    }
+  }
+
+  dfa->nclasses = n;
+  for ( int k = 0 ; k < n ; k++ ) {
+    for ( int c = 0 ; c < 256 ; c++ ) {
+      if ( chargroup_has_char( &part[ k ], (char)c ) ) dfa->classes[ c ] = k;
+    }
+  }
+}
+
+static unsigned hash_state( int *items, int n, int threshold, int accept ) {
+  unsigned h = 2166136261u;
+  for ( int i = 0 ; i < n ; i++ ) h = ( h ^ (unsigned)items[ i ] ) * 16777619u;
+  h = ( h ^ (unsigned)threshold ) * 16777619u;
+  h = ( h ^ (unsigned)accept ) * 16777619u;
+  return h;
+}
+
+static int same_state( struct builder *b, int s, int *items, int n, int threshold, int accept ) {
+  return b->nitems[ s ] == n && b->threshold[ s ] == threshold && b->accept[ s ] == accept
+    && !memcmp( b->items[ s ], items, n * sizeof( int ) );
+}
+
+static void rehash( struct builder *b ) {
+  int size = b->table_size ? 2 * b->table_size : 1024;
+  free( b->table );
+  b->table = xrealloc( NULL, size * sizeof( int ) );
+  b->table_size = size;
+  for ( int i = 0 ; i < size ; i++ ) b->table[ i ] = -1;
+  for ( int s = 0 ; s < b->nstates ; s++ ) {
+    unsigned h = hash_state( b->items[ s ], b->nitems[ s ], b->threshold[ s ], b->accept[ s ] );
+    int i = h & ( size - 1 );
+    while ( b->table[ i ] >= 0 ) i = ( i + 1 ) & ( size - 1 );
+    b->table[ i ] = s;
+  }
+}
+
+/* Renvoie l'indice de l'état (items, seuil, acceptation), en le créant au besoin */
+static int intern_state( struct builder *b, int *items, int n, int threshold, int accept ) {
+  unsigned h;
+  int i;
+
+  if ( 2 * ( b->nstates + 1 ) > b->table_size ) rehash( b );
+
+  h = hash_state( items, n, threshold, accept );
+  for ( i = h & ( b->table_size - 1 ) ; b->table[ i ] >= 0 ; i = ( i + 1 ) & ( b->table_size - 1 ) ) {
+    if ( same_state( b, b->table[ i ], items, n, threshold, accept ) ) return b->table[ i ];
+  }
+
+  if ( b->nstates == b->capacity ) {
+    b->capacity  = b->capacity ? 2 * b->capacity : 256;
+    b->items     = xrealloc( b->items,     b->capacity * sizeof( int * ) );
+    b->nitems    = xrealloc( b->nitems,    b->capacity * sizeof( int ) );
+    b->threshold = xrealloc( b->threshold, b->capacity * sizeof( int ) );
+    b->accept    = xrealloc( b->accept,    b->capacity * sizeof( int ) );
+  }
+
+  b->items[ b->nstates ] = xrealloc( NULL, ( n ? n : 1 ) * sizeof( int ) );
+  memcpy( b->items[ b->nstates ], items, n * sizeof( int ) );
+  b->nitems[ b->nstates ]    = n;
+  b->threshold[ b->nstates ] = threshold;
+  b->accept[ b->nstates ]    = accept;
+  b->table[ i ] = b->nstates;
+
+  return b->nstates++;
+}
+
+/*
+  Fait avancer un item (groupe g, drapeau '+' f) sur l'octet c, exactement
+  comme re_match. Met à jour la définition terminée avant (*before) ou
+  après (*after) la consommation de c, et ajoute l'éventuel item suivant.
+*/
+static void step_item( struct builder *b, int g, int f, int c, int *before, int *after, int *out, int *nout ) {
+  int d = b->def[ g ];
+  int end = b->end[ g ];
+
+  for ( ;; ) {
+    int in;
+
+    if ( g == end ) {
+      if ( d < *before ) *before = d;
+      return;
+    }
+
+    in = chargroup_has_char( &b->accepted[ g ], (char)c );
+    switch ( b->op[ g ] ) {
+    case OP_ONE:
+      if ( !in ) return;
+      g++;
+      goto consumed;
+    case OP_QUESTION:
+      g++;
+      if ( in ) goto consumed;
+      continue;
+    case OP_STAR:
+      if ( in ) { out[ ( *nout )++ ] = 2 * g; return; }
+      g++;
+      continue;
+    case OP_PLUS:
+      if ( in ) { out[ ( *nout )++ ] = 2 * g + 1; return; }
+      if ( !f ) return;
+      g++;
+      f = 0;
+      continue;
+    }
+  }
+
+ consumed:
+  if ( g == end ) {
+    if ( d < *after ) *after = d;
+  }
+  else {
+    out[ ( *nout )++ ] = 2 * g;
+  }
+}
+
+/*
+  Mode RE_MATCH_NFA : ajoute l'item (g, f) et tous ceux qu'il atteint par
+  transitions vides. Atteindre la fin de la définition met à jour *after.
+*/
+static void nfa_add( struct builder *b, int g, int f, int d, int end, int *after, int *out, int *nout ) {
+  for ( ;; ) {
+    int op;
+
+    if ( g == end ) {
+      if ( d < *after ) *after = d;
+      return;
+    }
+    if ( b->seen[ 2 * g + f ] ) return;
+    b->seen[ 2 * g + f ] = 1;
+    out[ ( *nout )++ ] = 2 * g + f;
+
+    op = b->op[ g ];
+    if ( OP_STAR != op && OP_QUESTION != op && !( OP_PLUS == op && f ) ) return;
+    g++;
+    f = 0;
+  }
+}
+
+/* Mode RE_MATCH_NFA : successeurs d'un item du groupe g sur l'octet c */
+static void nfa_step( struct builder *b, int g, int c, int *after, int *out, int *nout ) {
+  if ( !chargroup_has_char( &b->accepted[ g ], (char)c ) ) return;
+  switch ( b->op[ g ] ) {
+  case OP_STAR: nfa_add( b, g,     0, b->def[ g ], b->end[ g ], after, out, nout ); break;
+  case OP_PLUS: nfa_add( b, g,     1, b->def[ g ], b->end[ g ], after, out, nout ); break;
+  default:      nfa_add( b, g + 1, 0, b->def[ g ], b->end[ g ], after, out, nout ); break;
+  }
+}
+
+static int compare_items( const void *a, const void *b ) {
+  return *(const int *)a - *(const int *)b;
+}
+
+/* Trie les items (donc par définition) et oublie les marques de nfa_add */
+static void nfa_finish( struct builder *b, int *items, int n ) {
+  for ( int i = 0 ; i < n ; i++ ) b->seen[ items[ i ] ] = 0;
+  qsort( items, n, sizeof( int ), compare_items );
+}
+
+static void builder_free( struct builder *b ) {
+  for ( int s = 0 ; s < b->nstates ; s++ ) free( b->items[ s ] );
+  free( b->items );
+  free( b->nitems );
+  free( b->threshold );
+  free( b->accept );
+  free( b->table );
+  free( b->op );
+  free( b->def );
+  free( b->end );
+  free( b->accepted );
+  free( b->seen );
+}
+
+/* Caractère de mot (après le premier : '.' des directives) */
+static int word_char( unsigned char c ) {
+  return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) || c == '_';
+}
+
+/* Longueur du mot qui commence en p, 0 si p ne commence pas un mot */
+static int word_length( const unsigned char *p ) {
+  int n = 0;
+  if ( *p == '.' ) n++;
+  else if ( !word_char( *p ) || ( *p >= '0' && *p <= '9' ) ) return 0;
+  while ( word_char( p[ n ] ) ) n++;
+  return n;
+}
+
+static unsigned keyword_hash( unsigned seed, const unsigned char *p, int n ) {
+  unsigned h = 2166136261u ^ seed;
+  for ( int i = 0 ; i < n ; i++ ) h = ( h ^ p[ i ] ) * 16777619u;
+  return h ^ ( h >> 16 );
+}
+
+static int keyword_find( dfa_t dfa, const unsigned char *p, int n ) {
+  unsigned b = keyword_hash( 0, p, n ) & ( dfa->nbuckets - 1 );
+  unsigned i = keyword_hash( dfa->buckets[ b ], p, n ) & ( dfa->nslots - 1 );
+  const char *w = dfa->words + dfa->slots[ 2 * i + 1 ];
+
+  if ( dfa->slots[ 2 * i ] < 0 || strncmp( w, (const char *)p, n ) || w[ n ] ) return -1;
+  return dfa->slots[ 2 * i ];
+}
+
+/* Mot littéral de la regexp (groupes d'un seul caractère, sans
+   opérateur), ou NULL */
+static char *regexp_word( list_t re ) {
+  int n = (int)list_length( re ), i = 0;
+  char *w;
+
+  if ( 0 == n ) return NULL;
+  w = xrealloc( NULL, n + 1 );
+  for ( list_t l = re ; !list_is_empty( l ) ; l = list_next( l ), i++ ) {
+    chargroup_t cg = list_first( l );
+    int c, count = 0;
+
+    if ( NULL == cg || cg->flags ) break;
+    for ( c = 0 ; c < 256 && count < 2 ; c++ ) {
+      if ( chargroup_has_char( cg, (char)c ) ) {
+        w[ i ] = (char)c;
+        count++;
+      }
+    }
+    if ( count != 1 ) break;
+  }
+  w[ i ] = '\0';
+  if ( i < n || word_length( (unsigned char *)w ) != n ) {
+    free( w );
+    return NULL;
+  }
+  return w;
+}
+
+/* L'automate donne-t-il 'def' pour w, quel que soit l'octet qui suit ? */
+static int keyword_safe( dfa_t dfa, const char *w, int def ) {
+  int n = (int)strlen( w ), state = 0;
+  char *buf = xrealloc( NULL, n + 2 );
+  int ok = 1;
+
+  for ( int i = 0 ; i < n && state >= 0 ; i++ )
+    state = dfa->trans[ state * dfa->nclasses + dfa->classes[ (unsigned char)w[ i ] ] ].next;
+
+  memcpy( buf, w, n );
+  for ( int c = 0 ; c < 256 && ok && state >= 0 ; c++ ) {
+    char *end = NULL;
+    if ( word_char( c ) ) continue;
+    buf[ n ] = (char)c;
+    buf[ n + 1 ] = '\0';
+    ok = dfa->trans[ state * dfa->nclasses + dfa->classes[ c ] ].next < 0
+      && dfa_match( dfa, buf, &end ) == def && end == buf + n;
+  }
+  free( buf );
+  return ok && state >= 0;
+}
+
+static int compare_buckets( const void *a, const void *b ) {
+  const int *x = a, *y = b;
+  return x[ 1 ] != y[ 1 ] ? y[ 1 ] - x[ 1 ] : x[ 0 ] - y[ 0 ];
+}
+
+/* Construit la table des mots-clés ; renvoie 0 si le hachage échoue */
+static int keyword_table( dfa_t dfa, char **words, int *defs, int n, int nslots ) {
+  int nbuckets = nslots / 4 > 0 ? nslots / 4 : 1;
+  int *buckets = calloc( nbuckets, sizeof( int ) );
+  int *slots   = xrealloc( NULL, 2 * nslots * sizeof( int ) );
+  int *order   = xrealloc( NULL, 2 * nbuckets * sizeof( int ) );
+  int *of      = xrealloc( NULL, ( n + 1 ) * sizeof( int ) );
+  char *blob;
+  int size = 0;
+
+  assert( buckets );
+  for ( int i = 0 ; i < 2 * nslots ; i++ ) slots[ i ] = -1;
+  for ( int b = 0 ; b < nbuckets ; b++ ) {
+    order[ 2 * b ] = b;
+    order[ 2 * b + 1 ] = 0;
+  }
+  for ( int k = 0 ; k < n ; k++ ) {
+    of[ k ] = keyword_hash( 0, (unsigned char *)words[ k ], strlen( words[ k ] ) ) & ( nbuckets - 1 );
+    order[ 2 * of[ k ] + 1 ]++;
+  }
+
+  /* Les seaux les plus remplis d'abord : on cherche pour chacun une
+     graine qui envoie tous ses mots dans des cases libres distinctes */
+  qsort( order, nbuckets, 2 * sizeof( int ), compare_buckets );
+  for ( int o = 0 ; o < nbuckets && order[ 2 * o + 1 ] ; o++ ) {
+    int b = order[ 2 * o ], seed;
+
+    for ( seed = 1 ; seed < ( 1 << 16 ) ; seed++ ) {
+      int k, placed = 0;
+      for ( k = 0 ; k < n ; k++ ) {
+        unsigned i;
+        if ( of[ k ] != b ) continue;
+        i = keyword_hash( seed, (unsigned char *)words[ k ], strlen( words[ k ] ) ) & ( nslots - 1 );
+        if ( slots[ 2 * i ] >= 0 ) break;
+        slots[ 2 * i ] = k;
+        placed++;
+      }
+      if ( k == n ) break;
+      for ( int i = 0 ; i < nslots && placed ; i++ ) { /* on défait */
+        if ( slots[ 2 * i ] >= 0 && of[ slots[ 2 * i ] ] == b ) {
+          slots[ 2 * i ] = -1;
+          placed--;
+        }
+      }
+    }
+    if ( seed == ( 1 << 16 ) ) {
+      free( buckets ); free( slots ); free( order ); free( of );
+      return 0;
+    }
+    buckets[ b ] = seed;
+  }
+
+  for ( int k = 0 ; k < n ; k++ ) size += strlen( words[ k ] ) + 1;
+  blob = xrealloc( NULL, size + 1 );
+  size = 0;
+  for ( int i = 0 ; i < nslots ; i++ ) {
+    int k = slots[ 2 * i ];
+    if ( k < 0 ) continue;
+    strcpy( blob + size, words[ k ] );
+    slots[ 2 * i ]     = defs[ k ];
+    slots[ 2 * i + 1 ] = size;
+    size += strlen( words[ k ] ) + 1;
+  }
+
+  dfa->nbuckets   = nbuckets;
+  dfa->nslots     = nslots;
+  dfa->words_size = size;
+  dfa->buckets    = buckets;
+  dfa->slots      = slots;
+  dfa->words      = blob;
+  free( order );
+  free( of );
+  return 1;
+}
+
+/* Repère les définitions qui ne sont qu'un mot et remplit la table */
+static void keyword_build( dfa_t dfa, list_t *regexps, int count ) {
+  char **words = xrealloc( NULL, ( count + 1 ) * sizeof( char * ) );
+  int   *defs  = xrealloc( NULL, ( count + 1 ) * sizeof( int ) );
+  int n = 0;
+
+  for ( int d = 0 ; d < count ; d++ ) {
+    char *w = regexps[ d ] ? regexp_word( regexps[ d ] ) : NULL;
+    if ( NULL == w ) continue;
+    if ( keyword_safe( dfa, w, d ) ) {
+      words[ n ] = w;
+      defs[ n++ ] = d;
+    }
+    else free( w );
+  }
+
+  if ( n > 0 ) {
+    int nslots = 1;
+    while ( nslots < 2 * n ) nslots *= 2;
+    while ( !keyword_table( dfa, words, defs, n, nslots ) ) nslots *= 2;
+  }
+
+  for ( int k = 0 ; k < n ; k++ ) free( words[ k ] );
+  free( words );
+  free( defs );
+}
+
+/*
+  Boucles des états sur eux-mêmes. Une classe boucle si elle ramène dans
+  l'état sans rien accepter avant l'octet : sauter n octets de la boucle
+  revient alors à faire n fois la transition. La boucle n'est retenue que
+  si les octets d'arrêt, ou à défaut les octets répétés, sont au plus
+  RUN_BYTES ; le '\0' final arrête toujours l'automate.
+*/
+static void dfa_runs( dfa_t dfa ) {
+  dfa->runs = calloc( dfa->nstates, sizeof( *dfa->runs ) );
+  assert( dfa->runs );
+
+  for ( int s = 0 ; s < dfa->nstates ; s++ ) {
+    struct dfa_run *run = &dfa->runs[ s ];
+    unsigned char loop[ 256 ];
+    int nloop = 0;
+
+    for ( int c = 0 ; c < 256 ; c++ ) {
+      const struct dfa_trans *t = &dfa->trans[ s * dfa->nclasses + dfa->classes[ c ] ];
+      loop[ c ] = t->next == s && t->accept < 0;
+      nloop += loop[ c ];
+    }
+    if ( 0 == nloop || loop[ 0 ] ) continue;
+
+    run->kind = 256 - nloop <= RUN_BYTES ? RUN_UNTIL : nloop <= RUN_BYTES ? RUN_WHILE : RUN_NONE;
+    for ( int c = 0 ; c < 256 && run->kind != RUN_NONE ; c++ ) {
+      if ( loop[ c ] == ( run->kind == RUN_WHILE ) ) run->bytes[ run->nbytes++ ] = c;
+    }
+  }
+}
+
+static int run_has( const struct dfa_run *run, unsigned char c ) {
+  for ( int i = 0 ; i < run->nbytes ; i++ ) {
+    if ( run->bytes[ i ] == c ) return 1;
+  }
+  return 0;
+}
+
+#if defined(__SSE2__)
+/*
+  Les blocs sont alignés : ils ne débordent jamais sur la page suivante,
+  même en lisant après le '\0' qui arrête la boucle (comme memchr). Ces
+  octets hors de la chaîne sont ignorés, mais ASan les verrait.
+*/
+#if defined(__SANITIZE_ADDRESS__)
+#define RUN_NO_ASAN __attribute__(( no_sanitize_address ))
+#else
+#define RUN_NO_ASAN
+#endif
+
+/* Un bit par octet du bloc (aligné) qui sort de la boucle */
+RUN_NO_ASAN
+static unsigned run_block( const struct dfa_run *run, const unsigned char *block ) {
+  __m128i text = _mm_load_si128( (const __m128i *)block );
+  __m128i hits = _mm_setzero_si128();
+  unsigned mask;
+
+  for ( int i = 0 ; i < run->nbytes ; i++ )
+    hits = _mm_or_si128( hits, _mm_cmpeq_epi8( text, _mm_set1_epi8( (char)run->bytes[ i ] ) ) );
+  mask = (unsigned)_mm_movemask_epi8( hits );
+  return RUN_UNTIL == run->kind ? mask : ~mask & 0xFFFF;
+}
+
+RUN_NO_ASAN
+static const unsigned char *run_skip( const struct dfa_run *run, const unsigned char *p ) {
+  const unsigned char *block;
+  unsigned mask;
+
+  /* Boucle courte (un seul blanc...) : pas de bloc */
+  if ( run_has( run, *p ) == ( RUN_UNTIL == run->kind ) ) return p;
+
+  block = (const unsigned char *)( (uintptr_t)p & ~(uintptr_t)15 );
+  mask  = run_block( run, block ) & ( 0xFFFFu << ( p - block ) );
+  while ( !mask ) {
+    block += 16;
+    mask = run_block( run, block );
+  }
+  return block + __builtin_ctz( mask );
+}
+#else
+static const unsigned char *run_skip( const struct dfa_run *run, const unsigned char *p ) {
+  while ( run_has( run, *p ) != ( RUN_UNTIL == run->kind ) ) p++;
+  return p;
+}
+#endif
+
+dfa_t dfa_new( list_t *regexps, int count, int flags ) {
+  struct builder b;
+  dfa_t dfa = calloc( 1, sizeof( *dfa ) );
+  int *start, *next;
+  int nstart = 0, start_accept = count;
+  int rep[ 256 ];
+  struct dfa_trans *trans = NULL;
+  int *accept;
+  int trans_capacity = 0;
+
+  assert( dfa );
+  memset( &b, 0, sizeof( b ) );
+  b.nfa     = !!( flags & RE_MATCH_NFA );
+  b.longest = !!( flags & DFA_LONGEST );
+  builder_load( &b, regexps, count );
+  compute_classes( &b, dfa );
+
+  /* Un octet représentant par classe */
+  for ( int c = 255 ; c >= 0 ; c-- ) rep[ dfa->classes[ c ] ] = c;
+
+  /* Au plus un item par définition (glouton) ou deux par groupe (NFA) */
+  start  = xrealloc( NULL, ( 2 * b.ngroups + b.ndefs + 1 ) * sizeof( int ) );
+  next   = xrealloc( NULL, ( 2 * b.ngroups + b.ndefs + 1 ) * sizeof( int ) );
+  b.seen = calloc( 2 * b.ngroups + 2, 1 );
+  assert( b.seen );
+
+  /* État initial : le premier groupe de chaque définition non vide */
+  for ( int g = 0 ; g < b.ngroups ; g++ ) {
+    if ( 0 != g && b.def[ g - 1 ] == b.def[ g ] ) continue;
+    if ( b.nfa ) nfa_add( &b, g, 0, b.def[ g ], b.end[ g ], &start_accept, start, &nstart );
+    else         start[ nstart++ ] = 2 * g;
+  }
+  if ( b.nfa ) {
+    int nkept = 0;
+    nfa_finish( &b, start, nstart );
+    for ( int i = 0 ; i < nstart ; i++ ) {
+      if ( b.longest || b.def[ start[ i ] / 2 ] <= start_accept ) start[ nkept++ ] = start[ i ];
+    }
+    nstart = nkept;
+  }
+  intern_state( &b, start, nstart, b.longest ? b.ndefs : start_accept, start_accept < b.ndefs ? start_accept : -1 );
+
+  /* Construction par sous-ensembles, en largeur */
+  for ( int s = 0 ; s < b.nstates ; s++ ) {
+    if ( trans_capacity < b.nstates * dfa->nclasses ) {
+      trans_capacity = 2 * b.nstates * dfa->nclasses;
+      trans = xrealloc( trans, trans_capacity * sizeof( *trans ) );
+    }
+
+    for ( int k = 0 ; k < dfa->nclasses ; k++ ) {
+      struct dfa_trans *t;
+      int before = b.ndefs, after = b.ndefs;
+      int threshold, entry, nnext = 0, nkept = 0;
+
+      for ( int i = 0 ; i < b.nitems[ s ] ; i++ ) {
+        int item = b.items[ s ][ i ];
+        if ( b.nfa ) nfa_step( &b, item / 2, rep[ k ], &after, next, &nnext );
+        else         step_item( &b, item / 2, item % 2, rep[ k ], &before, &after, next, &nnext );
+      }
+      if ( b.nfa ) nfa_finish( &b, next, nnext );
+
+      if ( b.longest ) {
+        /* Pas de priorité : toute définition peut encore faire plus long */
+        threshold = b.ndefs;
+        nkept = nnext;
+        entry = after < b.ndefs ? after : -1;
+      }
+      else {
+        threshold = b.threshold[ s ];
+        if ( before < threshold ) threshold = before;
+        if ( after  < threshold ) threshold = after;
+
+        /* Les items sont rangés par définition : on coupe au seuil (la
+           définition du seuil peut encore allonger son match en mode NFA) */
+        for ( int i = 0 ; i < nnext ; i++ ) {
+          if ( b.def[ next[ i ] / 2 ] <= threshold ) next[ nkept++ ] = next[ i ];
+        }
+
+        entry = after < b.ndefs && after == threshold ? after : -1;
+      }
+
+      t = &trans[ s * dfa->nclasses + k ];
+      t->accept = before < b.threshold[ s ] ? before : -1;
+      t->next   = nkept || entry >= 0 ? intern_state( &b, next, nkept, threshold, entry ) : -1;
+    }
+  }
+
+  accept = xrealloc( NULL, b.nstates * sizeof( int ) );
+  memcpy( accept, b.accept, b.nstates * sizeof( int ) );
+
+  dfa->nstates = b.nstates;
+  dfa->trans   = xrealloc( trans, dfa->nstates * dfa->nclasses * sizeof( *trans ) );
+  dfa->accept  = accept;
+  dfa->owned   = 1;
+
+  free( start );
+  free( next );
+  builder_free( &b );
+
+  dfa_runs( dfa );
+  keyword_build( dfa, regexps, count );
+
+  return dfa;
+}
+
+void dfa_delete( dfa_t dfa ) {
+  if ( NULL == dfa ) return;
+  if ( dfa->owned ) {
+    free( (void *)dfa->trans );
+    free( (void *)dfa->accept );
+    free( (void *)dfa->buckets );
+    free( (void *)dfa->slots );
+    free( (void *)dfa->words );
+  }
+  free( dfa->runs );
+  free( dfa );
+}
+
+void dfa_tables( dfa_t dfa, struct dfa_tables *tables ) {
+  assert( dfa && tables );
+  tables->nclasses = dfa->nclasses;
+  tables->nstates  = dfa->nstates;
+  tables->classes  = dfa->classes;
+  tables->trans    = (const int *)dfa->trans;
+  tables->accept   = dfa->accept;
+  tables->nbuckets   = dfa->nbuckets;
+  tables->nslots     = dfa->nslots;
+  tables->words_size = dfa->words_size;
+  tables->buckets    = dfa->buckets;
+  tables->slots      = dfa->slots;
+  tables->words      = dfa->words;
+}
+
+dfa_t dfa_from_tables( const struct dfa_tables *tables ) {
+  dfa_t dfa = calloc( 1, sizeof( *dfa ) );
+
+  assert( dfa && tables );
+  dfa->nclasses = tables->nclasses;
+  dfa->nstates  = tables->nstates;
+  memcpy( dfa->classes, tables->classes, sizeof( dfa->classes ) );
+  dfa->trans    = (const struct dfa_trans *)tables->trans;
+  dfa->accept   = tables->accept;
+  dfa->nbuckets   = tables->nbuckets;
+  dfa->nslots     = tables->nslots;
+  dfa->words_size = tables->words_size;
+  dfa->buckets    = tables->buckets;
+  dfa->slots      = tables->slots;
+  dfa->words      = tables->words;
+  dfa->owned    = 0;
+  dfa_runs( dfa );
+
+  return dfa;
+}
+
+int dfa_match( dfa_t dfa, char *source, char **end ) {
+  return dfa_match_stop( dfa, source, end, NULL );
+}
+
+int dfa_match_stop( dfa_t dfa, char *source, char **end, char **stop ) {
+  const unsigned char *p = (const unsigned char *)source;
+  int state = 0;
+  int found = -1;
+  const unsigned char *found_end = p;
+
+  assert( dfa );
+
+  /* Mot-clé : un seul accès à la table au lieu du parcours */
+  if ( dfa->nslots ) {
+    int n = word_length( p );
+    if ( n > 0 && ( found = keyword_find( dfa, p, n ) ) >= 0 ) {
+      if ( end != NULL ) *end = source + n;
+      if ( stop != NULL ) *stop = source + n;
+      return found;
+    }
+  }
+
+  if ( dfa->accept[ 0 ] >= 0 ) found = dfa->accept[ 0 ]; /* match vide */
+
+  for ( ;; ) {
+    const struct dfa_trans *t = &dfa->trans[ state * dfa->nclasses + dfa->classes[ *p ] ];
+
+    /* Même position que l'acceptation précédente : la plus petite
+       définition gagne (ordre du fichier) */
+    if ( t->accept >= 0 && ( p != found_end || found < 0 || t->accept < found ) ) {
+      found = t->accept;
+      found_end = p;
+    }
+    if ( t->next < 0 ) break;
+
+    p++;
+    /* Deuxième tour d'une boucle : la suite se fait par blocs */
+    if ( t->next == state && dfa->runs[ state ].kind != RUN_NONE ) p = run_skip( &dfa->runs[ state ], p );
+    state = t->next;
+    if ( dfa->accept[ state ] >= 0 ) {
+      found = dfa->accept[ state ];
+      found_end = p;
+    }
+  }
+
+  if ( found >= 0 && end != NULL ) *end = (char *)found_end;
+  if ( stop != NULL ) *stop = (char *)p;
+
+  return found;
+}
+
+int dfa_state_count( dfa_t dfa ) {
+  assert( dfa );
+  return dfa->nstates;
+}
@@ -0,0 +1,366 @@
+/**
+ * @file lexcache.c
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Cache binaire de la table des lexèmes compilée.
+ *
+ * Le fichier est une image mémoire directement utilisable après mmap :
+ *
+ *   en-tête | définitions | chargroups | chaînes | classes | transitions | acceptations
+ *           | seaux | cases | mots (mots-clés de l'automate)
+ *
+ * Chaque section commence sur un multiple de 8 octets. Les entiers sont
+ * ceux de la machine : le cache est un fichier local, reconstruit dès que
+ * l'en-tête ne correspond pas (numéro de version, tailles des types,
+ * empreinte FNV-1a du fichier de définitions, options LEX_*).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <pyas/lexcache.h>
+#include <pyas/lexem.h>
+#include <pyas/list.h>
+#include <pyas/chargroup.h>
+#include <pyas/re_match.h>
+#include <pyas/dfa.h>
+
+#define LEXCACHE_MAGIC   "pyaslex"
+#define LEXCACHE_VERSION 2
+
+struct lexcache_header {
+  char     magic[8];
+  uint32_t version;
+  uint32_t sizes;        /* sizeof(int) et sizeof(struct chargroup)     */
+  uint64_t hash;         /* empreinte du fichier de définitions         */
+  uint64_t source_size;  /* taille du fichier de définitions            */
+  uint32_t flags;        /* options LEX_* de l'automate                 */
+  uint32_t ndefs;
+  uint32_t ngroups;
+  uint32_t nclasses;
+  uint32_t nstates;
+  uint32_t nbuckets;
+  uint32_t nslots;
+  uint32_t words_size;
+  uint64_t defs, groups, strings, classes, trans, accept; /* positions */
+  uint64_t buckets, slots, words;
+  uint64_t size;         /* taille totale du fichier                    */
+};
+
+struct lexcache_def {
+  uint32_t type;         /* position du type dans les chaînes           */
+  uint32_t regexp_str;   /* position de la regexp dans les chaînes      */
+  int32_t  first;        /* premier chargroup de la regexp              */
+  int32_t  ngroups;      /* nombre de chargroups, -1 : regexp invalide  */
+};
+
+struct lexcache {
+  unsigned char *base;   /* image du fichier (mmap ou malloc)           */
+  size_t         size;
+  int            mapped;
+  char         **types;
+  dfa_t          dfa;
+};
+
+#define LEXCACHE_SIZES ( (uint32_t)( sizeof( int ) << 16 | sizeof( struct chargroup ) ) )
+
+static uint64_t fnv1a( const unsigned char *p, size_t n ) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  while ( n-- ) {
+    h ^= *p++;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+static uint64_t align8( uint64_t n ) {
+  return ( n + 7 ) & ~(uint64_t)7;
+}
+
+static const struct lexcache_header *header( lexcache_t cache ) {
+  return (const struct lexcache_header *)cache->base;
+}
+
+/* Vérifie l'en-tête et que chaque section tient dans le fichier */
+static int lexcache_valid( const unsigned char *base, size_t size, uint64_t hash, uint64_t source_size, int flags ) {
+  const struct lexcache_header *h = (const struct lexcache_header *)base;
+  uint64_t trans_size;
+
+  if ( size < sizeof( *h ) ) return 0;
+  if ( memcmp( h->magic, LEXCACHE_MAGIC, sizeof( h->magic ) )
+       || h->version != LEXCACHE_VERSION || h->sizes != LEXCACHE_SIZES
+       || h->hash != hash || h->source_size != source_size
+       || h->flags != (uint32_t)flags || h->size != size ) return 0;
+
+  trans_size = 2 * sizeof( int ) * (uint64_t)h->nstates * h->nclasses;
+  return h->nstates > 0 && h->nclasses > 0 && h->nclasses <= 256
+    && h->defs    + h->ndefs * sizeof( struct lexcache_def )       <= h->groups
+    && h->groups  + h->ngroups * sizeof( struct chargroup )        <= h->strings
+    && h->strings                                                   <= h->classes
+    && h->classes + 256                                             <= h->trans
+    && h->trans   + trans_size                                      <= h->accept
+    && h->accept  + h->nstates * sizeof( int )                      <= h->buckets
+    && ( h->nslots == 0 || ( h->nbuckets > 0 && !( h->nbuckets & ( h->nbuckets - 1 ) )
+                             && !( h->nslots & ( h->nslots - 1 ) ) ) )
+    && h->buckets + h->nbuckets * sizeof( int )                     <= h->slots
+    && h->slots   + 2 * h->nslots * sizeof( int )                   <= h->words
+    && h->words   + h->words_size                                   <= size;
+}
+
+/* Compile regexp_file et construit l'image du cache en mémoire */
+static unsigned char *lexcache_build( char *regexp_file, uint64_t hash, uint64_t source_size, int flags, size_t *size ) {
+  list_t defs = list_of_defintions( regexp_file );
+  int ndefs, ngroups = 0, k;
+  uint64_t strings_size = 0;
+  list_t *regexps;
+  struct dfa_tables tables;
+  struct lexcache_header h;
+  unsigned char *base;
+  dfa_t dfa;
+
+  if ( !defs ) return NULL;
+
+  ndefs   = (int)list_length( defs );
+  regexps = calloc( ndefs + 1, sizeof( *regexps ) );
+  assert( regexps );
+  k = 0;
+  for ( list_t l = defs ; !list_is_empty( l ) ; l = list_next( l ), k++ ) {
+    regexps[ k ]  = lexdef_regexp( list_first( l ) );
+    ngroups      += (int)list_length( regexps[ k ] );
+    strings_size += strlen( lexdef_type( list_first( l ) ) ) + 1;
+    strings_size += strlen( lexdef_regexp_str( list_first( l ) ) ) + 1;
+  }
+
+  dfa = dfa_new( regexps, ndefs, ( ( flags & LEX_NFA ) ? RE_MATCH_NFA : RE_MATCH_GREEDY )
+                                | ( ( flags & LEX_LONGEST ) ? DFA_LONGEST : 0 ) );
+  dfa_tables( dfa, &tables );
+
+  memset( &h, 0, sizeof( h ) );
+  memcpy( h.magic, LEXCACHE_MAGIC, sizeof( h.magic ) );
+  h.version     = LEXCACHE_VERSION;
+  h.sizes       = LEXCACHE_SIZES;
+  h.hash        = hash;
+  h.source_size = source_size;
+  h.flags       = (uint32_t)flags;
+  h.ndefs       = ndefs;
+  h.ngroups     = ngroups;
+  h.nclasses    = tables.nclasses;
+  h.nstates     = tables.nstates;
+  h.nbuckets    = tables.nbuckets;
+  h.nslots      = tables.nslots;
+  h.words_size  = tables.words_size;
+  h.defs        = align8( sizeof( h ) );
+  h.groups      = align8( h.defs    + ndefs * sizeof( struct lexcache_def ) );
+  h.strings     = align8( h.groups  + ngroups * sizeof( struct chargroup ) );
+  h.classes     = align8( h.strings + strings_size );
+  h.trans       = align8( h.classes + 256 );
+  h.accept      = align8( h.trans   + 2 * sizeof( int ) * (uint64_t)h.nstates * h.nclasses );
+  h.buckets     = align8( h.accept  + h.nstates * sizeof( int ) );
+  h.slots       = align8( h.buckets + h.nbuckets * sizeof( int ) );
+  h.words       = align8( h.slots   + 2 * h.nslots * sizeof( int ) );
+  h.size        = align8( h.words   + h.words_size );
+
+  base = calloc( 1, h.size );
+  assert( base );
+  memcpy( base, &h, sizeof( h ) );
+
+  {
+    struct lexcache_def *d = (struct lexcache_def *)( base + h.defs );
+    struct chargroup    *g = (struct chargroup *)( base + h.groups );
+    char                *s = (char *)( base + h.strings );
+    uint32_t pos = 0;
+    int      first = 0;
+
+    k = 0;
+    for ( list_t l = defs ; !list_is_empty( l ) ; l = list_next( l ), k++ ) {
+      lexdef_t def = list_first( l );
+
+      d[ k ].type = pos;
+      strcpy( s + pos, lexdef_type( def ) );
+      pos += strlen( lexdef_type( def ) ) + 1;
+      d[ k ].regexp_str = pos;
+      strcpy( s + pos, lexdef_regexp_str( def ) );
+      pos += strlen( lexdef_regexp_str( def ) ) + 1;
+
+      d[ k ].first   = first;
+      d[ k ].ngroups = regexps[ k ] ? 0 : -1;
+      for ( list_t r = regexps[ k ] ; !list_is_empty( r ) ; r = list_next( r ) ) {
+        g[ first++ ] = *(chargroup_t)list_first( r );
+        d[ k ].ngroups++;
+      }
+    }
+  }
+  memcpy( base + h.classes, tables.classes, 256 );
+  memcpy( base + h.trans,   tables.trans,   2 * sizeof( int ) * (size_t)h.nstates * h.nclasses );
+  memcpy( base + h.accept,  tables.accept,  h.nstates * sizeof( int ) );
+  if ( h.nslots ) {
+    memcpy( base + h.buckets, tables.buckets, h.nbuckets * sizeof( int ) );
+    memcpy( base + h.slots,   tables.slots,   2 * h.nslots * sizeof( int ) );
+    memcpy( base + h.words,   tables.words,   h.words_size );
+  }
+
+  dfa_delete( dfa );
+  free( regexps );
+  list_delete( defs, lexdef_delete );
+
+  *size = h.size;
+  return base;
+}
+
+/* Écrit l'image dans un fichier temporaire renommé ensuite : un autre
+   processus ne voit jamais un cache à moitié écrit */
+static void lexcache_write( const char *path, const unsigned char *base, size_t size ) {
+  size_t len = strlen( path );
+  char  *tmp = malloc( len + 8 );
+  int    fd;
+
+  assert( tmp );
+  sprintf( tmp, "%s.XXXXXX", path );
+  fd = mkstemp( tmp );
+  if ( fd < 0 ) {
+    free( tmp );
+    return;
+  }
+  fchmod( fd, 0644 );
+  if ( write( fd, base, size ) != (ssize_t)size || close( fd ) || rename( tmp, path ) ) {
+    fprintf( stderr, "Warning: impossible d'écrire le cache '%s'.\n", path );
+    unlink( tmp );
+  }
+  free( tmp );
+}
+
+lexcache_t lexcache_open( char *regexp_file, int flags ) {
+  char       *source = file_to_string( regexp_file );
+  char       *path;
+  uint64_t    hash, source_size;
+  lexcache_t  cache;
+  int         fd;
+
+  flags &= LEX_NFA | LEX_LONGEST; /* seules les options de l'automate comptent */
+
+  if ( !source ) return NULL;
+  source_size = strlen( source );
+  hash        = fnv1a( (unsigned char *)source, source_size );
+  free( source );
+
+  cache = calloc( 1, sizeof( *cache ) );
+  /* Un fichier par jeu d'options : alterner LEX_NFA ou LEX_LONGEST ne le réécrit pas */
+  path  = malloc( strlen( regexp_file ) + sizeof( ".00.cache" ) );
+  assert( cache && path );
+  sprintf( path, "%s.%d.cache", regexp_file, flags );
+
+  fd = open( path, O_RDONLY );
+  if ( fd >= 0 ) {
+    struct stat st;
+    if ( !fstat( fd, &st ) && st.st_size > 0 ) {
+      void *map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+      if ( MAP_FAILED != map ) {
+        if ( lexcache_valid( map, st.st_size, hash, source_size, flags ) ) {
+          cache->base   = map;
+          cache->size   = st.st_size;
+          cache->mapped = 1;
+        }
+        else munmap( map, st.st_size );
+      }
+    }
+    close( fd );
+  }
+
+  if ( !cache->base ) {
+    cache->base = lexcache_build( regexp_file, hash, source_size, flags, &cache->size );
+    if ( !cache->base ) {
+      free( path );
+      free( cache );
+      return NULL;
+    }
+    lexcache_write( path, cache->base, cache->size );
+  }
+  free( path );
+
+  {
+    const struct lexcache_header *h = header( cache );
+    const struct lexcache_def    *d = (const struct lexcache_def *)( cache->base + h->defs );
+    struct dfa_tables tables;
+
+    cache->types = calloc( h->ndefs + 1, sizeof( *cache->types ) );
+    assert( cache->types );
+    for ( uint32_t k = 0 ; k < h->ndefs ; k++ )
+      cache->types[ k ] = (char *)( cache->base + h->strings + d[ k ].type );
+
+    tables.nclasses = h->nclasses;
+    tables.nstates  = h->nstates;
+    tables.classes  = cache->base + h->classes;
+    tables.trans    = (const int *)( cache->base + h->trans );
+    tables.accept   = (const int *)( cache->base + h->accept );
+    tables.nbuckets   = h->nbuckets;
+    tables.nslots     = h->nslots;
+    tables.words_size = h->words_size;
+    tables.buckets    = (const int *)( cache->base + h->buckets );
+    tables.slots      = (const int *)( cache->base + h->slots );
+    tables.words      = (const char *)( cache->base + h->words );
+    cache->dfa      = dfa_from_tables( &tables );
+  }
+
+  return cache;
+}
+
+void lexcache_close( lexcache_t cache ) {
+  if ( NULL == cache ) return;
+  dfa_delete( cache->dfa );
+  free( cache->types );
+  if ( cache->mapped ) munmap( cache->base, cache->size );
+  else free( cache->base );
+  free( cache );
+}
+
+int lexcache_count( lexcache_t cache ) {
+  assert( cache );
+  return (int)header( cache )->ndefs;
+}
+
+char **lexcache_types( lexcache_t cache ) {
+  assert( cache );
+  return cache->types;
+}
+
+dfa_t lexcache_dfa( lexcache_t cache ) {
+  assert( cache );
+  return cache->dfa;
+}
+
+list_t lexcache_definitions( lexcache_t cache ) {
+  const struct lexcache_header *h;
+  const struct lexcache_def    *d;
+  const struct chargroup       *g;
+  const char                   *s;
+  list_t defs = list_new();
+
+  assert( cache );
+  h = header( cache );
+  d = (const struct lexcache_def *)( cache->base + h->defs );
+  g = (const struct chargroup *)( cache->base + h->groups );
+  s = (const char *)( cache->base + h->strings );
+
+  for ( int k = (int)h->ndefs - 1 ; k >= 0 ; k-- ) {
+    list_t re = NULL;
+
+    if ( d[ k ].ngroups >= 0 ) {
+      re = list_new();
+      for ( int i = d[ k ].ngroups - 1 ; i >= 0 ; i-- ) {
+        chargroup_t cg = chargroup_new();
+        *cg = g[ d[ k ].first + i ];
+        re = list_add_first( cg, re );
+      }
+    }
+    defs = list_add_first( lexdef_new( (char *)s + d[ k ].type, (char *)s + d[ k ].regexp_str, re ), defs );
+  }
+
+  return defs;
+}
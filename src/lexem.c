@@ -11,6 +11,15 @@
 #include <string.h>
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 
 #include <pyas/lexem.h>
@@ -20,12 +29,81 @@
 #include <pyas/re_match.h>
 #include <pyas/chargroup.h>
 #include <pyas/regexp.h>
+#include <pyas/dfa.h>
+#include <pyas/lexcache.h>
+#include <pyas/lineindex.h>
+
+/* Bloc de l'arène des valeurs copiées par lexem_value() */
+struct lexarena {
+  struct lexarena *next;
+  size_t           used;
+  size_t           size;
+  char             data[];
+};
+
+#define LEXARENA_BLOCK 65536
+
+/*
+  Source d'une passe de lex() : le fichier projeté en mémoire (mmap) et
+  les types des définitions. Les lexèmes n'en sont que des vues (type,
+  position, longueur) et gardent une référence dessus : elle est libérée
+  avec le dernier d'entre eux, et l'arène des valeurs avec elle.
+*/
+struct lexsource {
+  char   *text;      /* source terminée par '\0'                       */
+  size_t  size;
+  size_t  map_size;  /* taille projetée, 0 si lue par file_to_string    */
+  char  **types;     /* types des définitions, terminé par NULL         */
+  int    *insn;      /* opcode et arité de chaque type (insn_table)     */
+  uint64_t *kinds;   /* catégories LX_* de chaque type (kind_table)     */
+  struct lexarena *values; /* copies de lexem_value(), libérées d'un coup */
+  size_t *newlines;  /* positions des '\n' (lineindex), faites à la
+                        première demande de ligne ou colonne            */
+  size_t  nnewlines;
+  int     indexed;
+  int     refs;      /* lexèmes vivants, plus lex_source pendant la passe */
+};
+
+/*
+  Lexème rangé dans un tableau (24 octets) : la source et les types sont
+  ceux du tableau, la ligne et la colonne sont calculées à la demande.
+*/
+struct lexrec {
+  size_t   offset;  /* position dans la source (lex_stream : dans text) */
+  uint64_t kinds;   /* catégories LX_* du type                          */
+  uint32_t length;
+  int32_t  type_id;
+};
 
-struct lexem {
-  char *type;
-  char *value;
-  int   line;    /* Start at line 1   */
-  int   column;  /* Start at column 0 */
+/*
+  Lexèmes d'une passe, rangés à la suite dans un seul tableau : ce sont
+  des vues qui ne prennent pas de référence sur la source (le tableau en
+  garde une pour tous), et le tout est libéré d'un coup.
+  Avec un lexer (lex_stream), le tableau n'est qu'une fenêtre : il est
+  rempli par lexer_next à la demande et vidé une fois consommé ; les
+  valeurs de ses lexèmes sont copiées dans text.
+  Les lexem_t rendus par le tableau sont faits à la demande dans une
+  struct lexem de l'appelant, qui garde la génération du tableau : elle
+  change quand ces lexèmes ne sont plus valides (fenêtre vidée, valeurs
+  déplacées, lexarray_edit).
+*/
+struct lexarray {
+  struct lexsource *source;
+  struct lexrec    *lexems;
+  size_t            count;
+  size_t            size;  /* place allouée dans lexems */
+  size_t            pos;   /* lexème courant du parser  */
+  struct lexer     *lexer; /* NULL : tous les lexèmes sont dans le tableau */
+  int               dense; /* LEX_NO_TRIVIA : aucun commentaire ni blanc   */
+  struct lexrec    *trivia; /* LEX_NO_TRIVIA, sans lexer : commentaires et
+                               blancs, à part                              */
+  size_t            trivia_count;
+  size_t            trivia_size;
+  char             *text;      /* lex_stream : valeurs de la fenêtre, terminées par '\0' */
+  size_t            text_used;
+  size_t            text_size;
+  int              *positions; /* lex_stream : ligne et colonne de chaque lexème */
+  unsigned          generation;
 };
 
 struct lexdef{
@@ -34,6 +112,61 @@ struct lexdef{
   list_t regexp_list; //liste renvoyé par reread
 };
 
+/* Préfixe de type de chaque catégorie LX_* (voir lexem.h) */
+static const char *lexem_kinds[LX_KINDS] = {
+  [LX_COMMENT]        = "comment",
+  [LX_BLANK]          = "blank",
+  [LX_NEWLINE]        = "newline",
+  [LX_COLON]          = "colon",
+  [LX_PAREN_LEFT]     = "paren::left",
+  [LX_PAREN_RIGHT]    = "paren::right",
+  [LX_BRACK_LEFT]     = "brack::left",
+  [LX_BRACK_RIGHT]    = "brack::right",
+  [LX_PYCST]          = "pycst",
+  [LX_PYCST_NONE]     = "pycst::None",
+  [LX_PYCST_TRUE]     = "pycst::True",
+  [LX_PYCST_FALSE]    = "pycst::False",
+  [LX_INTEGER]        = "integer",
+  [LX_INTEGER_HEX]    = "integer::hex",
+  [LX_INTEGER_DEC]    = "integer::dec",
+  [LX_FLOAT]          = "float",
+  [LX_STRING]         = "string",
+  [LX_VERSION_PYVM]   = "version_pyvm",
+  [LX_FLAGS]          = "flags",
+  [LX_FILENAME]       = "filename",
+  [LX_NAME]           = "name",
+  [LX_STACK_SIZE]     = "stack_size",
+  [LX_ARG_COUNT]      = "arg_count",
+  [LX_DIR]            = "dir",
+  [LX_DIR_SET]        = "dir::set",
+  [LX_DIR_INTERNED]   = "dir::interned",
+  [LX_DIR_CONSTS]     = "dir::consts",
+  [LX_DIR_NAMES]      = "dir::names",
+  [LX_DIR_VARNAMES]   = "dir::varnames",
+  [LX_DIR_FREEVARS]   = "dir::freevars",
+  [LX_DIR_CELLVARS]   = "dir::cellvars",
+  [LX_DIR_TEXT]       = "dir::text",
+  [LX_DIR_LINE]       = "dir::line",
+  [LX_DIR_CODE_START] = "dir::code_start",
+  [LX_DIR_CODE_END]   = "dir::code_end",
+  [LX_INSN]           = "insn",
+  [LX_INSN_0]         = "insn::0",
+  [LX_INSN_1]         = "insn::1",
+  [LX_SYMBOL]         = "symbol",
+};
+
+#define LX_BIT(kind) ((uint64_t)1 << (kind))
+#define LX_TRIVIA    (LX_BIT(LX_COMMENT) | LX_BIT(LX_BLANK))
+
+/* Catégories d'un type : même test de préfixe que lexem_type() */
+static uint64_t kind_mask( const char *type ) {
+  uint64_t mask = 0;
+  if ( !type ) return 0;
+  for ( int k = 0; k < LX_KINDS; k++ )
+    if ( !strncmp( type, lexem_kinds[k], strlen( lexem_kinds[k] ) ) ) mask |= LX_BIT(k);
+  return mask;
+}
+
 /*
   Constructor and callbacks for lists/queues of lexems:
  */
@@ -50,12 +183,92 @@ lexem_t lexem_new( char *type, char *value, int line, int column ) {
   if ( type  && *type  ) lex->type  = strdup( type );
   if ( value && *value ) lex->value = strdup( value );
 
+  lex->kinds  = kind_mask( lex->type );
   lex->line   = line;
   lex->column = column;
 
   return lex;
 }
 
+static void lexsource_release( struct lexsource *src ) {
+  if ( --src->refs > 0 ) return;
+  if ( src->map_size ) munmap( src->text, src->map_size );
+  else free( src->text );
+  while ( src->values ) {
+    struct lexarena *next = src->values->next;
+    free( src->values );
+    src->values = next;
+  }
+  free( src->newlines );
+  free( src->types );
+  free( src->insn );
+  free( src->kinds );
+  free( src );
+}
+
+//Lexème lu dans un tableau : pas vidé, déplacé ni modifié depuis
+#define lexem_check( lex ) \
+  assert( ( lex ) && ( !( lex )->array || ( lex )->array->generation == ( lex )->generation ) )
+
+//Lexème de lexem_new ou de lexer_next : sa valeur est une copie à lui
+static int lexem_owns_value( lexem_t lex ) {
+  return !lex->source || !lex->source->text;
+}
+
+//Copie de 'length' octets de la source, terminée par '\0', dans l'arène des valeurs
+static char *lexsource_strndup( struct lexsource *src, const char *text, size_t length ) {
+  struct lexarena *block = src->values;
+  if ( !block || block->size - block->used < length + 1 ) {
+    size_t size = length + 1 > LEXARENA_BLOCK ? length + 1 : LEXARENA_BLOCK;
+    block = malloc( sizeof( *block ) + size );
+    assert( block );
+    block->used = 0;
+    block->size = size;
+    block->next = src->values;
+    src->values = block;
+  }
+  char *value = block->data + block->used;
+  memcpy( value, text, length );
+  value[ length ] = '\0';
+  block->used += length + 1;
+  return value;
+}
+
+//Ligne et colonne de l'octet 'offset' de la source, par l'index des fins de ligne
+static void lexsource_position( struct lexsource *src, size_t offset, int *line, int *column ) {
+  if ( !src->indexed ) {
+    src->nnewlines = lineindex_new( src->text, src->size, &src->newlines );
+    src->indexed = 1;
+  }
+  lineindex_position( src->newlines, src->nnewlines, offset, line, column );
+}
+
+//Lexème vue : rien n'est copié, la valeur reste dans la source (line 0 : position calculée à la demande)
+static void lexem_view( lexem_t lex, struct lexsource *src, int type_id, size_t offset, size_t length, int line, int column ) {
+  lex->source  = src;
+  lex->type    = src->types[ type_id ];
+  lex->value   = NULL;
+  lex->offset  = offset;
+  lex->length  = length;
+  lex->type_id = type_id;
+  lex->kinds   = src->kinds[ type_id ];
+  lex->line    = line;
+  lex->column  = column;
+  lex->array   = NULL;
+}
+
+//Cette fonction crée un lexdef_t : le type et la regexp sont copiés, la liste renvoyée par re_read lui appartient désormais
+lexdef_t lexdef_new( char *type, char *regexp_str, list_t regexp_list ) {
+  lexdef_t lexdef = calloc( 1, sizeof( *lexdef ) );
+  assert( lexdef );
+
+  lexdef->type = strdup( type );
+  lexdef->regexp_str = strdup( regexp_str );
+  lexdef->regexp_list = regexp_list;
+
+  return lexdef;
+}
+
 static int re_node_delete_cb(void *data) {
     free(data);
     return 0;
@@ -68,7 +281,7 @@ static void re_delete(list_t re_list)
 }
 
 //Callback pour détruire un lexdef_t
-static int lexdef_delete_cb(void *_ld)
+int lexdef_delete(void *_ld)
 {
     lexdef_t ld = (lexdef_t)_ld;
     if (ld) {
@@ -86,7 +299,7 @@ static int lexdef_delete_cb(void *_ld)
 // permet de libérer le fichier de def des lexems
 static void free_lexdef_list(list_t def_list)
 {
-    list_delete(def_list, lexdef_delete_cb);
+    list_delete(def_list, lexdef_delete);
 }
 
 
@@ -95,11 +308,19 @@ static void free_lexdef_list(list_t def_list)
 // Cette fonction permet d'afficher un lexem courant dans le fichier assembleur à analyser.
 int lexem_print( void *_lex ) {
   lexem_t lex = _lex;
+  lexem_check( lex );
+  if ( !lexem_owns_value( lex ) && lex->length )
+    return printf( "[%d:%d:%s] %.*s",
+           lexem_line( lex ),
+           lexem_col( lex ),
+           lex->type,
+           (int)lex->length,
+           lex->source->text + lex->offset );
   return printf( "[%d:%d:%s] %s",
-         lex->line,
-         lex->column,
+         lexem_line( lex ),
+         lexem_col( lex ),
          lex->type,
-         lex->value );
+         lexem_value( lex ) );
 }
 
 int lexdef_print( void *_lexdef) {
@@ -115,8 +336,9 @@ int lexem_delete( void *_lex ) {
   lexem_t lex = _lex;
 
   if ( lex ) {
-    free( lex->type );
-    free( lex->value );
+    if ( !lex->source ) free( lex->type );
+    if ( lexem_owns_value( lex ) ) free( lex->value ); // sinon dans l'arène de la source
+    if ( lex->source ) lexsource_release( lex->source );
   }
 
   free( lex );
@@ -127,9 +349,137 @@ int lexem_delete( void *_lex ) {
 //------------------------------------------------------------------------------------
 
 
+/*
+  Index du premier octet, pour le moteur interprété (LEX_INTERP) : pour
+  chaque octet c, les définitions dont un lexème peut commencer par c,
+  dans l'ordre du fichier. L'ensemble d'une regexp est l'union des
+  groupes de tête jusqu'au premier groupe obligatoire (sans '*' ni '?') ;
+  une regexp qui peut matcher vide est candidate pour tous les octets.
+*/
+struct lexindex {
+  int     start[257]; /* candidats de c : defs[start[c]] à defs[start[c+1]-1] */
+  int    *defs;
+  list_t *regexps;
+  int     flags;      /* RE_MATCH_* */
+  int     longest;
+};
+
+/* Octets par lesquels un lexème de 're' peut commencer */
+static void lexindex_first(list_t re, struct chargroup *first) {
+  memset(first, 0, sizeof(*first));
+  for (list_t l = re; !list_is_empty(l); l = list_next(l)) {
+    chargroup_t cg = list_first(l);
+    struct chargroup accepted;
+    chargroup_accepted(&accepted, cg);
+    chargroup_union(first, first, &accepted);
+    if (!chargroup_has_operator_star(cg) && !chargroup_has_operator_question(cg))
+      return;
+  }
+  for (int c = 0; c < 256; c++) chargroup_add_char(first, (char)c); // regexp nullable
+}
+
+static struct lexindex *lexindex_new(list_t *regexps, int ndefs, int flags) {
+  struct lexindex *index = calloc(1, sizeof(*index));
+  struct chargroup *first = calloc(ndefs + 1, sizeof(*first));
+  assert(index && first);
+
+  for (int d = 0; d < ndefs; d++)
+    if (regexps[d]) lexindex_first(regexps[d], &first[d]); // regexp invalide : jamais candidate
+
+  /* Compter, puis ranger les candidats de chaque octet à la suite */
+  for (int c = 0; c < 256; c++) {
+    index->start[c + 1] = index->start[c];
+    for (int d = 0; d < ndefs; d++)
+      if (chargroup_has_char(&first[d], (char)c)) index->start[c + 1]++;
+  }
+  index->defs = calloc(index->start[256] + 1, sizeof(*index->defs));
+  assert(index->defs);
+  for (int c = 0, k = 0; c < 256; c++)
+    for (int d = 0; d < ndefs; d++)
+      if (chargroup_has_char(&first[d], (char)c)) index->defs[k++] = d;
+
+  free(first);
+  index->regexps = regexps;
+  index->flags   = (flags & LEX_NFA) ? RE_MATCH_NFA : RE_MATCH_GREEDY;
+  index->longest = flags & LEX_LONGEST;
+  return index;
+}
+
+static void lexindex_delete(struct lexindex *index) {
+  if (!index) return;
+  free(index->defs);
+  free(index);
+}
+
+/* Comme dfa_match, en essayant une à une les candidates du premier octet */
+static int lexindex_match(struct lexindex *index, char *source, char **end) {
+  unsigned char c = (unsigned char)*source;
+  int found = -1;
+
+  for (int k = index->start[c]; k < index->start[c + 1]; k++) {
+    int d = index->defs[k];
+    char *end_ptr = source;
+    if (!re_match_flags(index->regexps[d], source, &end_ptr, index->flags)) continue;
+    if (!index->longest) {
+      *end = end_ptr;
+      return d; // la première qui matche gagne
+    }
+    if (found < 0 || end_ptr > *end) {
+      found = d;
+      *end = end_ptr;
+    }
+  }
+  return found;
+}
+
+static lexarray_t lex_source(char **types, dfa_t dfa, struct lexindex *index, char *source_file, int flags);
+
+/* Opcode et arité de chaque type "insn::<arité>::<opcode hexa>" (types
+   terminé par NULL), lus une fois pour toutes : 2 entiers par type,
+   opcode -1 pour les autres types */
+static int *insn_table(char **types) {
+  int n = 0;
+  while (types[n]) n++;
+
+  int *insn = calloc(2 * n + 1, sizeof(*insn));
+  assert(insn);
+  for (int k = 0; k < n; k++) {
+    unsigned opcode;
+    int arity;
+    insn[2 * k] = -1;
+    if (sscanf(types[k], "insn::%d::%x", &arity, &opcode) == 2) {
+      insn[2 * k] = (int)opcode;
+      insn[2 * k + 1] = arity;
+    }
+  }
+  return insn;
+}
+
 /*à partir du chemin d'accès du fichier contenant les définitions de lexèmes et du fichier assembleur à analyser, 
 cette fonction renvoie une liste de lexdef_t.*/
 list_t lex(char *regexp_file, char *source_file) {
+  return lex_flags(regexp_file, source_file, LEX_DEFAULT);
+}
+
+/* Comme lex(), avec des options LEX_* (moteur de regexp, etc.) */
+list_t lex_flags(char *regexp_file, char *source_file, int flags) {
+  return lexarray_list(lex_array(regexp_file, source_file, flags));
+}
+
+/* Comme lex_flags(), les lexèmes rangés dans un tableau */
+lexarray_t lex_array(char *regexp_file, char *source_file, int flags) {
+  /* Table compilée relue depuis le cache binaire (mmap) si elle est à jour */
+  if ((flags & LEX_CACHE) && !(flags & LEX_INTERP)) {
+    lexcache_t cache = lexcache_open(regexp_file, flags & ~LEX_CACHE);
+    if (!cache) {
+      fprintf(stderr, "Erreur: Aucune définition de lexèmes chargée depuis '%s'.\n", regexp_file);
+      return NULL;
+    }
+    lexarray_t lexems = lex_array_dfa(lexcache_dfa(cache), lexcache_types(cache), source_file, flags);
+    lexcache_close(cache);
+    return lexems;
+  }
+
   /*Lire les définitions de lexèmes de la table des lexems */
   list_t regexp_definitions = list_of_defintions(regexp_file);
   if (!regexp_definitions) {
@@ -137,112 +487,555 @@ list_t lex(char *regexp_file, char *source_file) {
     return NULL;
   }
 
-    
   list_t def_list = regexp_definitions;
-    
 
-  /* Lire le code source assembleur en une seule chaîne, celle qui est contenue à l'interieur du fichier texte du code source assembleur*/
-  char *source_code = file_to_string(source_file);
-  //On Vérifie si le fichier existe
-  if (!source_code) {
-    fprintf(stderr, "Erreur: le fichier source '%s' n'existe pas.\n", source_file);
+  /* Compiler toutes les définitions en un seul automate (ou l'index du
+     premier octet avec LEX_INTERP) : l'indice renvoyé par dfa_match est
+     celui de la définition dans types[] */
+  int ndefs = (int)list_length(def_list);
+  char **types = calloc(ndefs + 1, sizeof(*types));
+  list_t *regexps = calloc(ndefs + 1, sizeof(*regexps));
+  if (!types || !regexps) {
+    fprintf(stderr, "Erreur d'allocation mémoire pour la table des définitions.\n");
+    free(types);
+    free(regexps);
     free_lexdef_list(def_list);
     return NULL;
   }
+  int k = 0;
+  for (list_t tmp = def_list; !list_is_empty(tmp); tmp = list_next(tmp), k++) {
+    lexdef_t def = (lexdef_t)list_first(tmp);
+    types[k] = def->type;
+    regexps[k] = def->regexp_list;
+  }
+  lexarray_t lexems;
+  if (flags & LEX_INTERP) {
+    struct lexindex *index = lexindex_new(regexps, ndefs, flags);
+    lexems = lex_source(types, NULL, index, source_file, flags);
+    lexindex_delete(index);
+  }
+  else {
+    dfa_t dfa = dfa_new(regexps, ndefs, ((flags & LEX_NFA) ? RE_MATCH_NFA : RE_MATCH_GREEDY)
+                                       | ((flags & LEX_LONGEST) ? DFA_LONGEST : 0));
+    lexems = lex_array_dfa(dfa, types, source_file, flags);
+    dfa_delete(dfa);
+  }
 
-  // Vérifier si le fichier est vide (chaine vide)
-  if (source_code[0] == '\0') {
-    fprintf(stderr, "Erreur: le fichier source '%s' est vide.\n", source_file);
-    free(source_code);
-    free_lexdef_list(regexp_definitions);
-    return NULL;
+  free(regexps);
+  free(types);
+  free_lexdef_list(def_list);
+
+  return lexems;
+}
+
+/* Découpe source_file avec un automate déjà compilé : types[i] est le
+   type des lexèmes reconnus par la définition i de l'automate */
+list_t lex_dfa(dfa_t dfa, char **types, char *source_file) {
+  return lexarray_list(lex_source(types, dfa, NULL, source_file, LEX_DEFAULT));
+}
+
+lexarray_t lex_array_dfa(dfa_t dfa, char **types, char *source_file, int flags) {
+  return lex_source(types, dfa, NULL, source_file, flags);
+}
+
+/* Copie des types en un seul bloc (ils doivent survivre aux définitions),
+   avec leurs opcodes et catégories */
+static void lexsource_types(struct lexsource *src, char **types) {
+  size_t ntypes = 0, chars = 0;
+
+  while (types[ntypes]) chars += strlen(types[ntypes++]) + 1;
+  src->types = malloc((ntypes + 1) * sizeof(char *) + chars);
+  assert(src->types);
+  char *p = (char *)(src->types + ntypes + 1);
+  for (size_t k = 0; k < ntypes; k++) {
+    src->types[k] = strcpy(p, types[k]);
+    p += strlen(p) + 1;
+  }
+  src->types[ntypes] = NULL;
+  src->insn = insn_table(types);
+  src->kinds = malloc((ntypes + 1) * sizeof(*src->kinds));
+  assert(src->kinds);
+  for (size_t k = 0; k < ntypes; k++) src->kinds[k] = kind_mask(types[k]);
+  src->refs = 1;
+}
+
+/*
+  Projette source_file en mémoire. Le lexer a besoin d'un '\0' final :
+  la fin de la dernière page projetée est remplie de zéros, sauf si la
+  taille du fichier est un multiple de la taille de page ; on le lit
+  alors avec file_to_string.
+*/
+static struct lexsource *lexsource_open(char *source_file, char **types) {
+  struct lexsource *src = calloc(1, sizeof(*src));
+  struct stat st;
+  int fd;
+
+  assert(src);
+  fd = open(source_file, O_RDONLY);
+  if (fd >= 0 && !fstat(fd, &st) && st.st_size > 0 && st.st_size % sysconf(_SC_PAGESIZE)) {
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED != map) {
+      src->text = map;
+      src->size = st.st_size;
+      src->map_size = st.st_size;
+    }
+  }
+  if (fd >= 0) close(fd);
+  if (!src->text) {
+    src->text = file_to_string(source_file);
+    if (!src->text) {
+      free(src);
+      return NULL;
+    }
+    src->size = strlen(src->text);
   }
 
-  list_t lexems_list = list_new();  
-  queue_t lexems_queue = queue_new();
-  int line = 1; 
-  int column = 0;
+  lexsource_types(src, types);
+  return src;
+}
+
+static void lexrec_set(struct lexrec *rec, struct lexsource *src, int type_id, size_t offset, size_t length) {
+  assert(length <= UINT32_MAX);
+  rec->offset  = offset;
+  rec->kinds   = src->kinds[type_id];
+  rec->length  = (uint32_t)length;
+  rec->type_id = type_id;
+}
+
+/* Ajoute un lexème au tableau, ou aux commentaires et blancs mis à part avec LEX_NO_TRIVIA */
+static void lexarray_add(lexarray_t lexems, int type_id, size_t offset, size_t length, int flags) {
+  struct lexsource *src = lexems->source;
+
+  if ((flags & LEX_NO_TRIVIA) && (src->kinds[type_id] & LX_TRIVIA)) {
+    /* Commentaire ou blanc : rangé à part, le parser ne le verra pas */
+    if (lexems->trivia_count == lexems->trivia_size) {
+      lexems->trivia_size = lexems->trivia_size ? 2 * lexems->trivia_size : 256;
+      lexems->trivia = realloc(lexems->trivia, lexems->trivia_size * sizeof(*lexems->trivia));
+      assert(lexems->trivia);
+    }
+    lexrec_set(lexems->trivia + lexems->trivia_count++, src, type_id, offset, length);
+  }
+  else {
+    if (lexems->count == lexems->size) {
+      lexems->size = lexems->size ? 2 * lexems->size : 1024;
+      lexems->lexems = realloc(lexems->lexems, lexems->size * sizeof(*lexems->lexems));
+      assert(lexems->lexems);
+    }
+    lexrec_set(lexems->lexems + lexems->count++, src, type_id, offset, length);
+  }
+}
+
+/*
+  Morceau de source découpé par lex_chunk : de 'start' jusqu'au premier
+  lexème qui atteint 'stop'. En sortie, 'end' est la position atteinte.
+  Lignes et colonnes ne sont pas suivies : elles sont retrouvées à la
+  demande par l'index des fins de ligne (lexsource_position).
+*/
+struct lexchunk {
+  lexarray_t        lexems;
+  dfa_t             dfa;
+  struct lexindex  *index;
+  size_t            start, stop, end;
+  int               flags;
+  int               error;   /* aucune définition ne matche en 'end' */
+  int               started; /* thread lancé, à attendre             */
+};
+
+static void *lex_chunk(void *_chunk) {
+  struct lexchunk *chunk = _chunk;
+  char *text = chunk->lexems->source->text;
 
     /*Parcourir la chaîne source jusqu'à la fin */
     //ON parcours par pointeur caractère par caractère
-  char *current = source_code; 
-  while (*current != '\0') {
-      /* On essaye de matcher une expression régulière définie. */
-    int matched = 0;
-    lexdef_t found_def = NULL;
-    char *best_end = NULL;  /* Pointeur fin de match pour la definition courante */
-    size_t best_len = 0;    /* Longueur max qu'on peut matcher*/
-        
-        /* On itère sur la liste des définitions (lexdef_t) pour trouver la première correspondance*/
-    list_t tmp = def_list;
-    while (!list_is_empty(tmp)) {
-      lexdef_t def = (lexdef_t)list_first(tmp);
-      tmp = list_next(tmp);
-      char *end_ptr = current;
-      int ok = re_match(def->regexp_list, current, &end_ptr);
-      if (ok) {
-        size_t length_matched = (size_t)(end_ptr - current);
-        found_def = def;
-        best_len  = length_matched;
-        best_end  = end_ptr;
-        matched   = 1;
-        break; // On arrête la boucle sur def_list, car on a trouvé un match
-        }
-      }
-
-    if (!matched) {
+  char *current = text + chunk->start;
+  while (*current != '\0' && (size_t)(current - text) < chunk->stop) {
+    /* Un seul parcours de l'automate donne la définition retenue : la
+       première qui matche, ou la plus longue avec LEX_LONGEST */
+    char *best_end = current;  /* Pointeur fin de match pour la definition trouvée */
+    int found = chunk->dfa ? dfa_match(chunk->dfa, current, &best_end) : lexindex_match(chunk->index, current, &best_end);
+
+    if (found < 0) {
       /* Si on n'a trouvé aucune expression régulière pour la portion courante,
           c'est une erreur de syntaxe. */
-      fprintf(stderr, "Erreur lexicale: Aucun lexème ne correspond à la position courante (line %d, colonne %d).\n",line, column);
-      free(source_code);
-      lexems_list = queue_to_list(lexems_queue);
-      list_delete(lexems_list, lexem_delete);
-      free_lexdef_list(def_list);
-      return NULL;
+      chunk->error = 1;
+      break;
     }
-        
-    /*On a un match => Créer un lexem_t pour la portion matched. */
-    size_t length_matched = best_len;
-    char *lex_value = strndup(current, length_matched);
-    if (!lex_value) {
-      fprintf(stderr, "Erreur d'allocation mémoire pour la valeur du lexème.\n");
-      free(source_code);
-      lexems_list = queue_to_list(lexems_queue);
-      list_delete(lexems_list, lexem_delete);
-      free_lexdef_list(def_list);
-      return NULL;
+    size_t length_matched = (size_t)(best_end - current);  /* Longueur du lexème */
+
+    /*On a un match => Ajouter au tableau un lexème qui désigne la portion matched dans la source (aucune copie). 
+      types[found] est le type de lexème, ex: "keyword", "identifier" */
+    lexarray_add(chunk->lexems, found, (size_t)(current - text), length_matched, chunk->flags);
+
+        /*Avancer dans la chaîne source. */
+    current = best_end;
+  }
+
+  chunk->end = (size_t)(current - text);
+  return NULL;
+}
+
+/*
+  LEX_PARALLEL : la source est coupée en morceaux d'au moins
+  LEX_PARALLEL_CHUNK octets, juste après une suite de '\n', et chaque
+  morceau est découpé par un thread. Les morceaux sont ensuite recollés
+  dans l'ordre (les lignes sont calculées à la demande, rien à décaler).
+
+  Une coupure n'est pas toujours une limite de lexème (chaîne sur
+  plusieurs lignes...) : si le morceau précédent déborde sur le suivant,
+  on reprend en séquentiel jusqu'à retomber au début d'un lexème du
+  morceau suivant, puis on recolle la suite. Le résultat est celui du
+  découpage séquentiel, erreurs lexicales comprises.
+
+  Taille minimale d'un morceau et nombre maximal de threads : ceux de
+  lex_parallel_options(), sinon LEX_PARALLEL_CHUNK et un par processeur.
+*/
+#ifndef LEX_PARALLEL_CHUNK
+#define LEX_PARALLEL_CHUNK (1 << 20)
+#endif
+
+static size_t lex_parallel_chunk;   /* 0 : LEX_PARALLEL_CHUNK       */
+static int    lex_parallel_threads; /* 0 : un thread par processeur */
+
+void lex_parallel_options(size_t chunk, int threads) {
+  lex_parallel_chunk   = chunk;
+  lex_parallel_threads = threads > 0 ? threads : 0;
+}
+
+static int lex_parallel(lexarray_t lexems, dfa_t dfa, struct lexindex *index, int flags, size_t *end) {
+  struct lexsource *src = lexems->source;
+  size_t chunk_size = lex_parallel_chunk ? lex_parallel_chunk : LEX_PARALLEL_CHUNK;
+  long cpus = lex_parallel_threads ? lex_parallel_threads : sysconf(_SC_NPROCESSORS_ONLN);
+  size_t pieces = src->size / chunk_size;
+
+  int threads = pieces > (size_t)cpus ? (int)cpus : (int)pieces;
+  if (threads < 2) return 0; // trop petit : lex_source s'en charge
+
+  struct lexchunk *chunks = calloc(threads, sizeof(*chunks));
+  pthread_t *tids = calloc(threads, sizeof(*tids));
+  assert(chunks && tids);
+
+  /* Coupures après une suite de '\n' */
+  size_t cut = 0;
+  for (int t = 0; t < threads; t++) {
+    size_t target = t + 1 < threads ? src->size * (t + 1) / threads : src->size;
+    chunks[t].start = cut;
+    if (cut < target) {
+      char *nl = memchr(src->text + target, '\n', src->size - target);
+      while (nl && nl[1] == '\n') nl++;
+      cut = nl ? (size_t)(nl + 1 - src->text) : src->size;
     }
+    chunks[t].stop = cut; // vide si le morceau précédent a dépassé target
+  }
 
-        /* Créer le lexem avec lexem_new(type, value, line, column). 
-           found_def->type est le type de lexème, ex: "keyword", "identifier" */
-    lexem_t lex = lexem_new(found_def->type, lex_value, line, column);
-    free(lex_value); // on peut free car lexem_new a fait un strdup
-        
-      /*L'ajouter à la liste de lexèmes. */
-    lexems_queue = enqueue(lexems_queue,lex);
-    //lexems = list_add_last(lexems, lex);
-    
-    
-
-        /*Mettre à jour la position (line, column) en fonction des caractères consommés. */
-    for (size_t i = 0; i < length_matched; i++) {
-      if (current[i] == '\n') {
-        line++;
-        column = 0;
-      } else {
-          column++;
+  /* Le thread appelant prend le premier morceau ; les autres vont dans
+     leur propre tableau (toutes les définitions : les commentaires et
+     blancs sont triés au recollage) */
+  for (int t = 0; t < threads; t++) {
+    chunks[t].dfa    = dfa;
+    chunks[t].index  = index;
+    if (t == 0) {
+      chunks[t].lexems = lexems;
+      chunks[t].flags  = flags;
+      continue;
+    }
+    chunks[t].lexems = calloc(1, sizeof(*chunks[t].lexems));
+    assert(chunks[t].lexems);
+    chunks[t].lexems->source = src;
+    src->refs++;
+    if (chunks[t].start < chunks[t].stop)
+      chunks[t].started = !pthread_create(&tids[t], NULL, lex_chunk, &chunks[t]);
+  }
+  lex_chunk(&chunks[0]);
+
+  /* Recollage : pos suit le dernier lexème ajouté */
+  size_t pos = chunks[0].end;
+  int error = chunks[0].error;
+  for (int t = 1; t < threads; t++) {
+    struct lexchunk *chunk = chunks + t;
+    if (chunk->started) pthread_join(tids[t], NULL);
+    else if (!error && chunk->start < chunk->stop) lex_chunk(chunk); // pas de thread disponible : on le fait ici
+
+    struct lexrec *records = chunk->lexems->lexems;
+    size_t count = chunk->lexems->count, i = 0;
+    while (!error && pos < chunk->stop && src->text[pos] != '\0') {
+      /* Premier lexème du morceau qui ne commence pas avant pos */
+      while (i < count && records[i].offset < pos) i++;
+      if (i < count && records[i].offset == pos) {
+        /* Au début d'un lexème du morceau : la suite est la même qu'en séquentiel */
+        for (; i < count; i++)
+          lexarray_add(lexems, records[i].type_id, records[i].offset, records[i].length, flags);
+        pos = chunk->end;
+        error = chunk->error;
+        break;
       }
+      /* Sinon un lexème en séquentiel, jusqu'au prochain du morceau */
+      struct lexchunk one = { lexems, dfa, index, pos, pos + 1, 0, flags, 0, 0 };
+      lex_chunk(&one);
+      pos = one.end;
+      error = one.error;
     }
-        /*Avancer dans la chaîne source. */
-    current = best_end;
+    lexarray_delete(chunk->lexems);
+  }
+
+  free(chunks);
+  free(tids);
+  *end = pos;
+  return error ? -1 : 1;
+}
+
+/* Boucle de lex_dfa, avec l'automate ou à défaut l'index du premier octet */
+static lexarray_t lex_source(char **types, dfa_t dfa, struct lexindex *index, char *source_file, int flags) {
+  /* Projeter le code source assembleur en mémoire : les lexèmes n'en seront que des vues */
+  struct lexsource *src = lexsource_open(source_file, types);
+  //On Vérifie si le fichier existe
+  if (!src) {
+    fprintf(stderr, "Erreur: le fichier source '%s' n'existe pas.\n", source_file);
+    return NULL;
+  }
+
+  // Vérifier si le fichier est vide (chaine vide)
+  if (src->text[0] == '\0') {
+    fprintf(stderr, "Erreur: le fichier source '%s' est vide.\n", source_file);
+    lexsource_release(src);
+    return NULL;
+  }
+
+  lexarray_t lexems = calloc(1, sizeof(*lexems));
+  assert(lexems);
+  lexems->source = src; // le tableau garde la référence de la passe
+  lexems->dense = (flags & LEX_NO_TRIVIA) != 0;
+
+  size_t end = 0;
+  int error = 0;
+  int done = (flags & LEX_PARALLEL) ? lex_parallel(lexems, dfa, index, flags, &end) : 0;
+  if (done) error = done < 0;
+  else {
+    struct lexchunk all = { lexems, dfa, index, 0, src->size, 0, flags, 0, 0 };
+    lex_chunk(&all);
+    error = all.error;
+    end = all.end;
+  }
+
+  if (error) {
+    /* Si on n'a trouvé aucune expression régulière pour la portion courante,
+        c'est une erreur de syntaxe. */
+    int line, column;
+    lexsource_position(src, end, &line, &column);
+    fprintf(stderr, "Erreur lexicale: Aucun lexème ne correspond à la position courante (line %d, colonne %d).\n",line, column);
+    lexarray_delete(lexems);
+    return NULL;
+  }
+
+  return lexems;
+}
+
+/*
+  Lexer par blocs : le fichier est lu LEXER_CHUNK octets à la fois et
+  seule sa partie non consommée reste dans buf (terminée par '\0'). Si
+  l'automate s'arrête sur ce '\0' avant la fin du fichier, le lexème
+  peut continuer dans le bloc suivant : on lit la suite et on recommence
+  au début du lexème. Les lexèmes en sont des copies ; la source ne sert
+  qu'aux types, opcodes et catégories (son texte reste NULL).
+*/
+#ifndef LEXER_CHUNK
+#define LEXER_CHUNK 65536
+#endif
+
+struct lexer {
+  struct lexsource *source;
+  dfa_t       dfa;
+  dfa_t       dfa_owned; /* automate compilé par lexer_open, sinon NULL */
+  lexcache_t  cache;     /* table relue par lexer_open avec LEX_CACHE   */
+  int         fd;
+  int         eof;
+  int         error;     /* erreur lexicale ou de lecture rencontrée    */
+  int         flags;     /* LEX_NO_TRIVIA : commentaires et blancs sautés */
+  char       *buf;
+  size_t      size;      /* place allouée dans buf                      */
+  size_t      start;     /* premier octet non consommé                  */
+  size_t      fill;      /* octets lus dans buf                         */
+  size_t      offset;    /* position de buf[start] dans le fichier      */
+  int         line;
+  int         column;
+};
+
+/* Garde la partie non consommée en tête de buf et lit un bloc de plus
+   (relu si interrompu par un signal ; erreur de lecture : lexer->error) */
+static void lexer_refill(lexer_t lexer) {
+  size_t rest = lexer->fill - lexer->start;
+
+  if (rest) memmove(lexer->buf, lexer->buf + lexer->start, rest); /* buf est NULL au premier appel */
+  lexer->start = 0;
+  lexer->fill = rest;
+  if (lexer->size < rest + LEXER_CHUNK + 1) {
+    lexer->size = 2 * lexer->size > rest + LEXER_CHUNK + 1 ? 2 * lexer->size : rest + LEXER_CHUNK + 1;
+    lexer->buf = realloc(lexer->buf, lexer->size);
+    assert(lexer->buf);
+  }
+  ssize_t n;
+  do n = read(lexer->fd, lexer->buf + lexer->fill, lexer->size - 1 - lexer->fill);
+  while (n < 0 && errno == EINTR);
+  if (n > 0) lexer->fill += n;
+  else {
+    if (n < 0) {
+      fprintf(stderr, "Erreur: lecture de la source impossible : %s.\n", strerror(errno));
+      lexer->error = 1;
+    }
+    lexer->eof = 1;
+  }
+  lexer->buf[lexer->fill] = '\0';
+}
+
+lexer_t lexer_open_dfa(dfa_t dfa, char **types, char *source_file, int flags) {
+  lexer_t lexer = calloc(1, sizeof(*lexer));
+  assert(lexer);
+
+  lexer->fd = open(source_file, O_RDONLY);
+  if (lexer->fd < 0) {
+    fprintf(stderr, "Erreur: le fichier source '%s' n'existe pas.\n", source_file);
+    free(lexer);
+    return NULL;
+  }
+  lexer_refill(lexer);
+  if (lexer->error || !lexer->fill) {
+    if (!lexer->error) fprintf(stderr, "Erreur: le fichier source '%s' est vide.\n", source_file);
+    close(lexer->fd);
+    free(lexer->buf);
+    free(lexer);
+    return NULL;
+  }
+
+  lexer->source = calloc(1, sizeof(*lexer->source));
+  assert(lexer->source);
+  lexsource_types(lexer->source, types);
+  lexer->dfa = dfa;
+  lexer->flags = flags;
+  lexer->line = 1;
+  return lexer;
+}
+
+/* Comme lex_array(), sans index du premier octet : LEX_INTERP est ignoré */
+lexer_t lexer_open(char *regexp_file, char *source_file, int flags) {
+  lexer_t lexer;
+
+  if (flags & LEX_CACHE) {
+    lexcache_t cache = lexcache_open(regexp_file, flags);
+    if (!cache) {
+      fprintf(stderr, "Erreur: Aucune définition de lexèmes chargée depuis '%s'.\n", regexp_file);
+      return NULL;
+    }
+    lexer = lexer_open_dfa(lexcache_dfa(cache), lexcache_types(cache), source_file, flags);
+    if (lexer) lexer->cache = cache;
+    else lexcache_close(cache);
+    return lexer;
   }
 
-  free(source_code);
+  list_t def_list = list_of_defintions(regexp_file);
+  if (!def_list) {
+    fprintf(stderr, "Erreur: Aucune définition de lexèmes chargée depuis '%s'.\n", regexp_file);
+    return NULL;
+  }
+  int ndefs = (int)list_length(def_list);
+  char **types = calloc(ndefs + 1, sizeof(*types));
+  list_t *regexps = calloc(ndefs + 1, sizeof(*regexps));
+  assert(types && regexps);
+  int k = 0;
+  for (list_t tmp = def_list; !list_is_empty(tmp); tmp = list_next(tmp), k++) {
+    lexdef_t def = (lexdef_t)list_first(tmp);
+    types[k] = def->type;
+    regexps[k] = def->regexp_list;
+  }
+  dfa_t dfa = dfa_new(regexps, ndefs, ((flags & LEX_NFA) ? RE_MATCH_NFA : RE_MATCH_GREEDY)
+                                     | ((flags & LEX_LONGEST) ? DFA_LONGEST : 0));
+  lexer = lexer_open_dfa(dfa, types, source_file, flags);
+  if (lexer) lexer->dfa_owned = dfa;
+  else dfa_delete(dfa);
+
+  free(regexps);
+  free(types);
   free_lexdef_list(def_list);
 
-  lexems_list = queue_to_list(lexems_queue);
+  return lexer;
+}
 
-  return lexems_list; 
+/* Lexème suivant dans *lex (sans valeur) : 1, ou 0 à la fin du fichier,
+   -1 sur une erreur lexicale ou de lecture. *text est son texte dans
+   buf, valable jusqu'à l'appel suivant */
+static int lexer_fill(lexer_t lexer, struct lexem *lex, const char **text) {
+  for (;;) {
+    if (lexer->error) return -1; // aussi après un lexer_refill() qui a échoué
+    char *current = lexer->buf + lexer->start;
+    char *limit = lexer->buf + lexer->fill;
+    char *best_end = current, *stop = current;
+
+    if (current == limit) {
+      if (lexer->eof) return 0;
+      lexer_refill(lexer);
+      continue;
+    }
+    if (*current == '\0') return 0; // comme lex() : la source s'arrête au premier '\0'
+
+    int found = dfa_match_stop(lexer->dfa, current, &best_end, &stop);
+    if (stop == limit && !lexer->eof) {
+      lexer_refill(lexer); // le lexème peut continuer dans le bloc suivant
+      continue;
+    }
+    if (found < 0) {
+      fprintf(stderr, "Erreur lexicale: Aucun lexème ne correspond à la position courante (line %d, colonne %d).\n", lexer->line, lexer->column);
+      lexer->error = 1;
+      return -1;
+    }
+
+    size_t length = (size_t)(best_end - current);
+    int skip = (lexer->flags & LEX_NO_TRIVIA) && (lexer->source->kinds[found] & LX_TRIVIA);
+    if (!skip) {
+      lexem_view(lex, lexer->source, found, lexer->offset, length, lexer->line, lexer->column);
+      *text = current;
+    }
+
+    /* Ligne et colonne suivantes : seuls les '\n' du lexème comptent */
+    char *last = NULL;
+    for (char *nl = current; (nl = memchr(nl, '\n', best_end - nl)); nl++) {
+      lexer->line++;
+      last = nl;
+    }
+    lexer->column = last ? (int)(best_end - last - 1) : lexer->column + (int)length;
+    lexer->start += length;
+    lexer->offset += length;
+    if (!skip) return 1;
+  }
+}
+
+lexem_t lexer_next(lexer_t lexer) {
+  lexem_t lex = malloc(sizeof(*lex));
+  const char *text;
+  assert(lex);
+
+  if (lexer_fill(lexer, lex, &text) <= 0) {
+    free(lex);
+    return NULL;
+  }
+  if (lex->length) {
+    lex->value = strndup(text, lex->length);
+    assert(lex->value);
+  }
+  lexer->source->refs++;
+  return lex;
+}
+
+int lexer_error(lexer_t lexer) {
+  assert(lexer);
+  return lexer->error;
+}
+
+void lexer_close(lexer_t lexer) {
+  if (!lexer) return;
+  lexsource_release(lexer->source);
+  close(lexer->fd);
+  free(lexer->buf);
+  if (lexer->dfa_owned) dfa_delete(lexer->dfa_owned);
+  if (lexer->cache) lexcache_close(lexer->cache);
+  free(lexer);
 }
 
 /*----------------------------------------------------------*/
@@ -364,7 +1157,7 @@ char *file_to_string(char *source_file){
 
 lexem_t lexem_peek( list_t *lexems ) {
   list_t l = *lexems;
-  while (lexem_type(list_first(l), "comment") || lexem_type(list_first(l), "blank"))
+  while (((lexem_t)list_first(l))->kinds & LX_TRIVIA)
     l = list_next(l);
   return list_first(l);
 }
@@ -372,7 +1165,7 @@ lexem_t lexem_peek( list_t *lexems ) {
 lexem_t lexem_advance( list_t *lexems ) {
   do {
     *lexems = list_del_first(*lexems, lexem_delete);// on supprime les commentaires et les blancs
-  } while (lexem_type(list_first(*lexems), "comment") || lexem_type(list_first(*lexems), "blank"));
+  } while (((lexem_t)list_first(*lexems))->kinds & LX_TRIVIA);
   return list_first(*lexems);
 }
 
@@ -380,28 +1173,402 @@ int next_lexem_is( list_t *lexems, char *type ) {
   return lexem_type(lexem_peek(lexems), type); 
 }
 
+/* Comme next_lexem_is(), sans comparer de chaînes */
+int next_lexem_is_kind( list_t *lexems, int kind ) {
+  return lexem_is(lexem_peek(lexems), kind);
+}
+
+int lexem_is( lexem_t lex, int kind ) {
+  lexem_check(lex);
+  return (lex->kinds & LX_BIT(kind)) != 0;
+}
+
+/*
+  Tableau de lexèmes (lex_array) :
+ */
+
+//Vide la fenêtre de lex_stream, et les valeurs copiées avec
+static void lexarray_clear( lexarray_t lexems ) {
+  lexems->count = lexems->pos = 0;
+  lexems->text_used = 0;
+  lexems->generation++;
+}
+
+void lexarray_delete( lexarray_t lexems ) {
+  if ( !lexems ) return;
+  lexarray_clear( lexems );
+  lexsource_release( lexems->source );
+  lexer_close( lexems->lexer );
+  free( lexems->lexems );
+  free( lexems->trivia );
+  free( lexems->text );
+  free( lexems->positions );
+  free( lexems );
+}
+
+lexarray_t lex_stream( lexer_t lexer ) {
+  if ( !lexer ) return NULL;
+  lexarray_t lexems = calloc( 1, sizeof( *lexems ) );
+  assert( lexems );
+  lexems->source = lexer->source;
+  lexems->source->refs++;
+  lexems->lexer = lexer;
+  lexems->dense = (lexer->flags & LEX_NO_TRIVIA) != 0;
+  return lexems;
+}
+
+//Ajoute le lexème suivant du lexer, en vidant d'abord la fenêtre si tout y est consommé
+static int lexarray_pull( lexarray_t lexems ) {
+  struct lexem lex;
+  const char *value;
+  if ( lexer_fill( lexems->lexer, &lex, &value ) <= 0 ) return 0;
+  if ( lexems->pos == lexems->count ) lexarray_clear( lexems );
+  if ( lexems->count == lexems->size ) {
+    lexems->size = lexems->size ? 2 * lexems->size : 16;
+    lexems->lexems = realloc( lexems->lexems, lexems->size * sizeof( *lexems->lexems ) );
+    lexems->positions = realloc( lexems->positions, 2 * lexems->size * sizeof( *lexems->positions ) );
+    assert( lexems->lexems && lexems->positions );
+  }
+  if ( lexems->text_size - lexems->text_used < lex.length + 1 ) {
+    while ( lexems->text_size - lexems->text_used < lex.length + 1 )
+      lexems->text_size = lexems->text_size ? 2 * lexems->text_size : 4096;
+    lexems->text = realloc( lexems->text, lexems->text_size );
+    assert( lexems->text );
+    lexems->generation++; // valeurs déplacées
+  }
+  memcpy( lexems->text + lexems->text_used, value, lex.length );
+  lexems->text[ lexems->text_used + lex.length ] = '\0';
+  lexrec_set( lexems->lexems + lexems->count, lexems->source, lex.type_id, lexems->text_used, lex.length );
+  lexems->text_used += lex.length + 1;
+  lexems->positions[ 2 * lexems->count ]     = lex.line;
+  lexems->positions[ 2 * lexems->count + 1 ] = lex.column;
+  lexems->count++;
+  return 1;
+}
+
+//Lexème 'rec' du tableau (ou de ses commentaires et blancs) dans 'lex'
+static lexem_t lexarray_view( lexarray_t lexems, const struct lexrec *rec, lexem_t lex ) {
+  if ( !rec ) return NULL;
+  lexem_view( lex, lexems->source, rec->type_id, rec->offset, rec->length, 0, 0 );
+  lex->array      = lexems;
+  lex->generation = lexems->generation;
+  if ( lexems->lexer ) {
+    /* Fenêtre de lex_stream : valeur copiée dans text, position gardée */
+    size_t i = (size_t)( rec - lexems->lexems );
+    lex->value  = rec->length ? lexems->text + rec->offset : NULL;
+    lex->line   = lexems->positions[ 2 * i ];
+    lex->column = lexems->positions[ 2 * i + 1 ];
+  }
+  return lex;
+}
+
+//Copie chaque lexème du tableau dans un lexem_t alloué seul (qui garde une référence sur la source), puis libère le tableau
+list_t lexarray_list( lexarray_t lexems ) {
+  queue_t lexems_queue = queue_new();
+  if ( !lexems ) return list_new();
+  for ( size_t i = 0; i < lexems->count; i++ ) {
+    lexem_t lex = malloc( sizeof( *lex ) );
+    assert( lex );
+    lexarray_view( lexems, lexems->lexems + i, lex );
+    lex->array = NULL; // alloué seul : ne dépend plus du tableau
+    if ( lex->value ) {
+      lex->value = strdup( lex->value ); // fenêtre de lex_stream : la copie a sa valeur
+      assert( lex->value );
+    }
+    lex->source->refs++;
+    lexems_queue = enqueue( lexems_queue, lex );
+  }
+  if ( lexems->lexer ) {
+    lexem_t lex;
+    while ( ( lex = lexer_next( lexems->lexer ) ) ) lexems_queue = enqueue( lexems_queue, lex );
+  }
+  lexarray_delete( lexems );
+  return queue_to_list( lexems_queue );
+}
+
+size_t lexarray_length( lexarray_t lexems ) {
+  assert( lexems );
+  return lexems->count;
+}
+
+lexem_t lexarray_get( lexarray_t lexems, size_t i, struct lexem *lex ) {
+  assert( lexems && lex );
+  return lexarray_view( lexems, i < lexems->count ? lexems->lexems + i : NULL, lex );
+}
+
+//Lexème courant, sans vue : commentaires et blancs sautés, fenêtre remplie au besoin
+static struct lexrec *lexarray_current( lexarray_t lexems ) {
+  /* LEX_NO_TRIVIA : rien à sauter */
+  if ( lexems->dense ) {
+    if ( lexems->pos == lexems->count && lexems->lexer ) lexarray_pull( lexems );
+  }
+  else do {
+    while ( lexems->pos < lexems->count && ( lexems->lexems[ lexems->pos ].kinds & LX_TRIVIA ) )
+      lexems->pos++;
+  } while ( lexems->pos == lexems->count && lexems->lexer && lexarray_pull( lexems ) );
+  return lexems->pos < lexems->count ? lexems->lexems + lexems->pos : NULL;
+}
+
+lexem_t lexarray_peek( lexarray_t lexems, struct lexem *lex ) {
+  assert( lexems && lex );
+  return lexarray_view( lexems, lexarray_current( lexems ), lex );
+}
+
+void lexarray_advance( lexarray_t lexems ) {
+  assert( lexems );
+  if ( lexarray_current( lexems ) ) lexems->pos++; // rien n'est libéré : le tableau l'est d'un coup
+}
+
+size_t lexarray_trivia_length( lexarray_t lexems ) {
+  assert( lexems );
+  return lexems->trivia_count;
+}
+
+lexem_t lexarray_trivia( lexarray_t lexems, size_t i, struct lexem *lex ) {
+  assert( lexems && lex );
+  return lexarray_view( lexems, i < lexems->trivia_count ? lexems->trivia + i : NULL, lex );
+}
+
+int lexarray_next_is( lexarray_t lexems, int kind ) {
+  assert( lexems );
+  struct lexrec *rec = lexarray_current( lexems );
+  return rec && ( rec->kinds & LX_BIT( kind ) );
+}
+
+void lexarray_count( lexarray_t lexems, int stop, int nkinds, const int *kinds, size_t *counts ) {
+  assert( lexems && ( !nkinds || ( kinds && counts ) ) );
+  memset( counts, 0, nkinds * sizeof( *counts ) );
+  /* lex_stream : au plus LEXARRAY_LOOKAHEAD lexèmes lus d'avance ; avec
+     un lexème courant, lexarray_pull ne vide plus la fenêtre */
+  if ( !lexarray_current( lexems ) ) return;
+  for ( size_t i = lexems->pos ; i < lexems->count
+          || ( lexems->lexer && i - lexems->pos < LEXARRAY_LOOKAHEAD && lexarray_pull( lexems ) ) ; i++ ) {
+    uint64_t rec_kinds = lexems->lexems[ i ].kinds;
+    if ( rec_kinds & LX_BIT( stop ) ) break;
+    for ( int k = 0; k < nkinds; k++ )
+      if ( rec_kinds & LX_BIT( kinds[ k ] ) ) counts[ k ]++;
+  }
+}
+
+//Ajoute un lexème au tableau 'records' de 'count' lexèmes et 'size' places
+static void lexrec_push( struct lexrec **records, size_t *count, size_t *size, struct lexrec *rec ) {
+  if ( *count == *size ) {
+    *size = *size ? 2 * *size : 64;
+    *records = realloc( *records, *size * sizeof( **records ) );
+    assert( *records );
+  }
+  (*records)[ (*count)++ ] = *rec;
+}
+
+/*
+  Re-lexe 'lexems' après le remplacement de 'deleted' octets à la
+  position 'offset' par les 'length' octets de 'text'.
+
+  Reprise : le lexème qui contient offset, ou un précédent si l'automate
+  avait lu jusqu'à offset pour le reconnaître (dfa_match_stop). Arrêt :
+  dès qu'un lexème se termine après le texte inséré, au début d'un ancien
+  lexème ; la suite du texte est inchangée, donc ses lexèmes aussi, et
+  seules leurs positions sont décalées. Lignes et colonnes sont
+  recalculées à la demande ; si l'index des fins de ligne de l'ancienne
+  source était fait, celui de la nouvelle en est recollé.
+*/
+int lexarray_edit( lexarray_t lexems, dfa_t dfa, size_t offset, size_t deleted, const char *text, size_t length ) {
+  assert( lexems && dfa );
+  if ( lexems->lexer || lexems->dense ) {
+    fprintf( stderr, "Erreur: lexarray_edit a besoin de tous les lexèmes (ni lex_stream, ni LEX_NO_TRIVIA).\n" );
+    return -1;
+  }
+
+  struct lexsource *old = lexems->source;
+  struct lexrec    *records = lexems->lexems;
+  size_t            count = lexems->count;
+  if ( offset > old->size || deleted > old->size - offset ) {
+    fprintf( stderr, "Erreur: modification hors de la source (position %zu, %zu octets).\n", offset, deleted );
+    return -1;
+  }
+
+  /* Nouvelle source : le texte modifié, avec les types de l'ancienne */
+  struct lexsource *src = calloc( 1, sizeof( *src ) );
+  assert( src );
+  src->size = old->size - deleted + length;
+  src->text = malloc( src->size + 1 );
+  assert( src->text );
+  memcpy( src->text, old->text, offset );
+  memcpy( src->text + offset, text, length );
+  memcpy( src->text + offset + length, old->text + offset + deleted, old->size - offset - deleted );
+  src->text[ src->size ] = '\0';
+  lexsource_types( src, old->types );
+  ptrdiff_t delta = (ptrdiff_t)length - (ptrdiff_t)deleted;
+
+  if ( old->indexed ) {
+    /* Index recollé : fins de ligne avant offset, du texte inséré, puis après */
+    size_t before, after, count_text;
+    size_t *inserted;
+    for ( before = 0; before < old->nnewlines && old->newlines[ before ] < offset; before++ );
+    for ( after = before; after < old->nnewlines && old->newlines[ after ] < offset + deleted; after++ );
+    count_text = lineindex_new( src->text + offset, length, &inserted );
+    src->nnewlines = before + count_text + old->nnewlines - after;
+    src->newlines = malloc( ( src->nnewlines + 1 ) * sizeof( *src->newlines ) );
+    assert( src->newlines );
+    memcpy( src->newlines, old->newlines, before * sizeof( *src->newlines ) );
+    for ( size_t i = 0; i < count_text; i++ )
+      src->newlines[ before + i ] = inserted[ i ] + offset;
+    for ( size_t i = after; i < old->nnewlines; i++ )
+      src->newlines[ before + count_text + i - after ] = old->newlines[ i ] + delta;
+    free( inserted );
+    src->indexed = 1;
+  }
+
+  /* Premier lexème à reprendre */
+  size_t lo = 0, hi = count;
+  while ( lo < hi ) {
+    size_t mid = ( lo + hi ) / 2;
+    if ( records[ mid ].offset + records[ mid ].length > offset ) hi = mid;
+    else lo = mid + 1;
+  }
+  size_t first = lo;
+  while ( first > 0 ) {
+    char *end, *stop;
+    dfa_match_stop( dfa, old->text + records[ first - 1 ].offset, &end, &stop );
+    if ( (size_t)( stop - old->text ) < offset ) break;
+    first--;
+  }
+
+  size_t pos = 0;
+  if ( first < count ) pos = records[ first ].offset;
+  else if ( count > 0 ) pos = records[ count - 1 ].offset + records[ count - 1 ].length;
+
+  /* Lexèmes refaits, jusqu'à retomber au début d'un ancien lexème */
+  struct lexrec *fresh = NULL;
+  size_t nfresh = 0, fresh_size = 0;
+  size_t next = first; /* ancien lexème candidat à la reprise */
+  while ( src->text[ pos ] != '\0' ) {
+    if ( pos >= offset + length ) {
+      size_t old_pos = pos - delta;
+      while ( next < count && records[ next ].offset < old_pos ) next++;
+      if ( next < count && records[ next ].offset == old_pos ) break;
+    }
+
+    char *best_end = src->text + pos;
+    int found = dfa_match( dfa, src->text + pos, &best_end );
+    if ( found < 0 ) {
+      int line, column;
+      lexsource_position( src, pos, &line, &column );
+      fprintf( stderr, "Erreur lexicale: Aucun lexème ne correspond à la position courante (line %d, colonne %d).\n", line, column );
+      free( fresh );
+      lexsource_release( src );
+      return -1;
+    }
+    struct lexrec rec;
+    lexrec_set( &rec, src, found, pos, (size_t)( best_end - ( src->text + pos ) ) );
+    lexrec_push( &fresh, &nfresh, &fresh_size, &rec );
+    pos = (size_t)( best_end - src->text );
+  }
+  if ( src->text[ pos ] == '\0' ) next = count;
+
+  /* Tableau final : lexèmes avant la reprise, refaits, puis anciens décalés */
+  size_t kept = count - next;
+  size_t total = first + nfresh + kept;
+  if ( total > lexems->size ) {
+    lexems->size = total;
+    records = realloc( records, total * sizeof( *records ) );
+    assert( records );
+  }
+  if ( kept ) {
+    memmove( records + first + nfresh, records + next, kept * sizeof( *records ) );
+    for ( struct lexrec *rec = records + first + nfresh; rec < records + total; rec++ )
+      rec->offset += delta;
+  }
+  if ( nfresh ) memcpy( records + first, fresh, nfresh * sizeof( *records ) ); // rien de refait : fresh est NULL
+  free( fresh );
+  lexems->generation++; // lexèmes lus sur l'ancienne source
+
+  lexsource_release( old );
+  lexems->source = src;
+  lexems->lexems = records;
+  lexems->count  = total;
+  lexems->pos    = 0;
+
+  return (int)nfresh;
+}
+
 int lexem_type_strict( lexem_t lex, char *type ) {
+  lexem_check( lex );
   return !strcmp( lex->type, type );
 }
 
 int lexem_type( lexem_t lex, char *type ) {
+    lexem_check( lex );
     return lex->type == strstr( lex->type, type );
 }
 
 int value_compare( lexem_t lex, char* value ) {
-  return !strcmp(lex->value, value);
+  return !strcmp(lexem_value(lex), value);
 }
 
 char *lexem_value( lexem_t lexem ) {
+  lexem_check( lexem );
+  /* Lexème vue : la copie terminée par '\0' n'est faite qu'à la demande */
+  if ( !lexem_owns_value( lexem ) && !lexem->value && lexem->length ) {
+    lexem->value = lexsource_strndup( lexem->source, lexem->source->text + lexem->offset, lexem->length );
+  }
   return lexem->value;
 }
 
+char *lexem_typename( lexem_t lex ) {
+  lexem_check(lex);
+  return lex->type;
+}
+
+const char *lexem_text( lexem_t lex, size_t *length ) {
+  lexem_check(lex);
+  if ( lexem_owns_value( lex ) ) {
+    if ( length ) *length = lex->value ? strlen( lex->value ) : 0;
+    return lex->value;
+  }
+  if ( length ) *length = lex->length;
+  return lex->source->text + lex->offset;
+}
+
+//Lexème vue : position calculée au premier appel, puis gardée
+static void lexem_position( lexem_t lex ) {
+  if ( !lex->line && lex->source && lex->source->text )
+    lexsource_position( lex->source, lex->offset, &lex->line, &lex->column );
+}
+
 int lexem_line( lexem_t lex ) {
-  assert(lex);
+  lexem_check(lex);
+  lexem_position( lex );
   return lex->line;
 } 
 
 int lexem_col( lexem_t lex ) {
-  assert(lex);
+  lexem_check(lex);
+  lexem_position( lex );
   return lex->column;
 }
+
+int lexem_opcode( lexem_t lex ) {
+  lexem_check(lex);
+  return lex->source ? lex->source->insn[ 2 * lex->type_id ] : -1;
+}
+
+int lexem_arity( lexem_t lex ) {
+  lexem_check(lex);
+  return lex->source ? lex->source->insn[ 2 * lex->type_id + 1 ] : 0;
+}
+
+char *lexdef_type( lexdef_t lexdef ) {
+  assert(lexdef);
+  return lexdef->type;
+}
+
+list_t lexdef_regexp( lexdef_t lexdef ) {
+  assert(lexdef);
+  return lexdef->regexp_list;
+}
+
+char *lexdef_regexp_str( lexdef_t lexdef ) {
+  assert(lexdef);
+  return lexdef->regexp_str;
+}
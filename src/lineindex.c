@@ -0,0 +1,110 @@
+/**
+ * @file lineindex.c
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Index des fins de ligne d'un texte.
+ *
+ * Le texte est comparé à '\n' par blocs de 32 (AVX2) ou 16 (SSE2)
+ * octets ; chaque bit du masque obtenu est une fin de ligne. La fin du
+ * texte, ou tout le texte hors x86, est parcourue avec memchr.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define LINEINDEX_AVX2
+#endif
+
+#include <pyas/lineindex.h>
+
+/* Positions relevées, dans un tableau qui grandit */
+struct newlines {
+  size_t *offsets;
+  size_t  count;
+  size_t  size;
+};
+
+static void newlines_add( struct newlines *nl, size_t offset ) {
+  if ( nl->count == nl->size ) {
+    nl->size = nl->size ? 2 * nl->size : 1024;
+    nl->offsets = realloc( nl->offsets, nl->size * sizeof( *nl->offsets ) );
+    assert( nl->offsets );
+  }
+  nl->offsets[ nl->count++ ] = offset;
+}
+
+/* Un bit par '\n' dans 'mask', pour les octets à partir de 'base' */
+static void newlines_mask( struct newlines *nl, size_t base, unsigned mask ) {
+  while ( mask ) {
+    newlines_add( nl, base + __builtin_ctz( mask ) );
+    mask &= mask - 1;
+  }
+}
+
+#ifdef LINEINDEX_AVX2
+__attribute__(( target( "avx2" ) ))
+static size_t scan_avx2( const char *text, size_t size, struct newlines *nl ) {
+  const __m256i newline = _mm256_set1_epi8( '\n' );
+  size_t i = 0;
+
+  for ( ; i + 32 <= size; i += 32 ) {
+    __m256i block = _mm256_loadu_si256( (const __m256i *)( text + i ) );
+    newlines_mask( nl, i, (unsigned)_mm256_movemask_epi8( _mm256_cmpeq_epi8( block, newline ) ) );
+  }
+  return i;
+}
+#endif
+
+#ifdef __SSE2__
+static size_t scan_sse2( const char *text, size_t size, struct newlines *nl ) {
+  const __m128i newline = _mm_set1_epi8( '\n' );
+  size_t i = 0;
+
+  for ( ; i + 16 <= size; i += 16 ) {
+    __m128i block = _mm_loadu_si128( (const __m128i *)( text + i ) );
+    newlines_mask( nl, i, (unsigned)_mm_movemask_epi8( _mm_cmpeq_epi8( block, newline ) ) );
+  }
+  return i;
+}
+#endif
+
+size_t lineindex_new( const char *text, size_t size, size_t **newlines ) {
+  struct newlines nl = { NULL, 0, 0 };
+  size_t done = 0;
+
+  assert( text && newlines );
+
+#if defined(LINEINDEX_AVX2)
+  if ( __builtin_cpu_supports( "avx2" ) ) done = scan_avx2( text, size, &nl );
+  else
+#endif
+  {
+#if defined(__SSE2__)
+    done = scan_sse2( text, size, &nl );
+#endif
+  }
+
+  /* Fin du texte (ou tout le texte sans SSE2) */
+  for ( const char *p = text + done; ( p = memchr( p, '\n', size - ( p - text ) ) ); p++ )
+    newlines_add( &nl, (size_t)( p - text ) );
+
+  *newlines = nl.offsets;
+  return nl.count;
+}
+
+void lineindex_position( const size_t *newlines, size_t count, size_t offset, int *line, int *column ) {
+  /* Nombre de '\n' avant offset */
+  size_t lo = 0, hi = count;
+  while ( lo < hi ) {
+    size_t mid = ( lo + hi ) / 2;
+    if ( newlines[ mid ] < offset ) lo = mid + 1;
+    else hi = mid;
+  }
+  if ( line )   *line   = (int)lo + 1;
+  if ( column ) *column = (int)( offset - ( lo ? newlines[ lo - 1 ] + 1 : 0 ) );
+}
@@ -6,139 +6,20 @@
 #include <stdint.h>
 #include <pyas/lexem.h>
 #include <pyas/parse.h>
-
-/* Structures de données (rappel, simplifiées) */
-
-#define NULL_MARKER           '0'  // Absence d’objet
-#define NONE_MARKER           'N'  // None
-#define FALSE_MARKER          'F'  // False
-#define TRUE_MARKER           'T'  // True
-#define INT_MARKER            'i'  // Entier signé sur 4 octets
-#define INT64_MARKER          'I'  // Entier signé sur 8 octets (plus généré)
-#define FLOAT_MARKER          'f'  // Chaîne d’un réel (max : 17 caractères)
-#define BINARY_FLOAT_MARKER   'g'  // Réel binaire sur 8 octets (double)
-#define COMPLEX_MARKER        'x'  // Deux chaînes pour un complexe
-#define BINARY_COMPLEX_MARKER 'y'  // Deux réels pour un complexe
-#define STRING_MARKER         's'  // Chaîne
-#define STRINGREF_MARKER      'R'  // Référence à une chaîne internée
-#define TUPLE_MARKER          '('  // Tuple
-#define LIST_MARKER           '['  // Liste
-#define DICT_MARKER           '{'  // Dictionnaire
-#define SET_MARKER            '<'  // Ensemble
-#define CODE_MARKER           'c'  // Objet de code
-#define STOP_ITER_MARKER      'S'  // Arrêt d’un itérateur
-#define ELLIPSIS_MARKER       '.'  // ...
-#define LONG_MARKER           'l'  // Entier signé en base 15
-#define UNICODE_MARKER        'u'  // Chaîne Unicode
-#define INTERNED_MARKER       't'  // Chaîne Unicode internée
-#define UNKNOWN_MARKER        '?'  // Objet de type inconnu
-#define FROZENSET_MARKER      '>'  // Ensemble en lecture seule
-
-#define OPTIMIZED               0x0001  // Optimisation active
-#define NEWLOCALS               0x0002  // Création d’un nouvel espace local de variables
-#define VARARGS                 0x0004  // Fonction acceptant des arguments variables (*args)
-#define VARKEYWORDS             0x0008  // Fonction acceptant des arguments mots-clés (**kwargs)
-#define NESTED                  0x0010  // Fonction imbriquée
-#define GENERATOR               0x0020  // Fonction génératrice
-#define NOFREE                  0x0040  // Pas de variables libres
-#define COROUTINE               0x0080  // Fonction coroutine
-#define ITERABLE_COROUTINE      0x0100  // Coroutine itérable
-#define ASYNC_GENERATOR         0x0200  // Générateur asynchrone
-#define FUTURE_DIVISION         0x20000 // Division avec comportement Python 3 (/ pour float, // pour int)
-#define FUTURE_ABSOLUTE_IMPORT  0x40000 // Importations absolues par défaut
-#define FUTURE_WITH_STATEMENT   0x80000 // Utilisation du "with"
-#define FUTURE_PRINT_FUNCTION   0x100000 // Utilisation de "print()" comme fonction
-#define FUTURE_UNICODE_LITERALS 0x200000 // Les littéraux sont des chaînes Unicode par défaut
-#define FUTURE_BARRY_AS_BDFL    0x400000 // Fonctionnalité humoristique "BARRY"
-#define FUTURE_GENERATOR_STOP   0x800000 // Stop itérateur sur la fin du générateur (évite StopIteration)
-#define FUTURE_ANNOTATIONS      0x1000000 // Support des annotations différées (PEP 563)
-
-typedef unsigned int pyobj_type ;
-
-/* Déclaration avant usage */
-struct py_codeblock;
-
-/* Structure globale pyobj_t */
-struct pyobj {
-    pyobj_type type;
-    unsigned int refcount;
-
-    union {
-        /* Pour stocker des sous-champs sous forme de liste de pyobj_t */
-        struct {
-            pyobj_t *value;
-            int size;
-        } list;
-
-        /* Pour stocker une chaîne */
-        struct {
-            char *buffer;
-            int length;
-        } string;
-
-        /* Pour stocker un bloc de code complet (champ unique) */
-        struct py_codeblock *codeblock;
-
-        /* Pour stocker un nombre, etc. */
-        union {
-            int integer;
-            int64_t integer64;
-            double real;
-            struct {
-                double real;
-                double imag;
-            } complex;
-        } number;
-
-    } py;
-};
-
-/* Codeblock : structure utilisée dans le champ union->codeblock */
-
-typedef struct py_codeblock {
-    int version_pyvm;
-    struct {
-        int arg_count;
-        int local_count;
-        int stack_size;
-        int flags;
-    } header;
-
-    pyobj_t parent; // non-géré ici
-
-    struct {
-        struct {
-            int magic;       // cst
-            time_t timestamp;// à ajouter
-            int source_size;
-        } header;
-
-        struct {
-            pyobj_t interned;
-            pyobj_t bytecode; // contiendra le « code »
-            pyobj_t consts;
-            pyobj_t names; 
-            pyobj_t varnames; 
-            pyobj_t freevars;
-            pyobj_t cellvars;
-        } content;
-
-        struct {
-            pyobj_t filename;
-            pyobj_t name;
-            int firstlineno; 
-            pyobj_t lnotab;
-        } trailer;
-    } binary;
-} py_codeblock;
+#include <pyas/pyobj.h>
+#include <pyas/bytebuf.h>
 
 /* Gestion d'erreurs de parsing */
 
-void print_parse_error( char *msg, list_t *lexems ) {
+void print_parse_error( char *msg, lexarray_t lexems ) {
     /* On admet que la chaîne de caractère msg contient
        exactement deux fois le motif %d */
-    int line = lexem_line(lexem_peek(lexems));
-    int col  = lexem_col (lexem_peek(lexems));
+    struct lexem lex;
+    lexem_t lx = lexarray_peek(lexems, &lex);
+    /* Fin des lexèmes : position du dernier */
+    if (!lx && lexarray_length(lexems)) lx = lexarray_get(lexems, lexarray_length(lexems) - 1, &lex);
+    int line = lx ? lexem_line(lx) : 0;
+    int col  = lx ? lexem_col (lx) : 0;
 
     fprintf(stderr, msg, line, col);
 }
@@ -153,14 +34,58 @@ static pyobj_t new_pyobj(pyobj_type type) {
     return obj;
 }
 
-/* Alloue un pyobj de type STRING_NODE et y stocke la chaîne. */
-static pyobj_t new_string_obj(const char *s, pyobj_type type) {
+/* Chaîne de 'length' octets, qui peut contenir des '\0' : l'objet prend
+   'bytes' (alloué, length + 1 octets, libéré avec lui) sans le recopier.
+   Toutes les chaînes écrites dans le .pyc sont construites ainsi */
+static pyobj_t new_bytes_obj(char *bytes, int length, pyobj_type type) {
     pyobj_t obj = new_pyobj(type);
-    obj->py.string.length = (int)strlen(s);
-    obj->py.string.buffer = strdup(s);
+    bytes[length] = '\0';
+    obj->py.string.length = length;
+    obj->py.string.buffer = bytes;
     return obj;
 }
 
+/* Chaîne d'octets remplie dans 'buf' (bytecode, lnotab), vide ensuite */
+static pyobj_t new_bytebuf_obj(struct bytebuf *buf, pyobj_type type) {
+    size_t length;
+    char *bytes = bytebuf_release(buf, &length);
+    return new_bytes_obj(bytes, (int)length, type);
+}
+
+/* Chaîne d'un lexème string : sans les guillemets, avec les séquences
+   d'échappement (\n, \t, \r, \\, \', \", \xHH, \ooo) décodées */
+static pyobj_t new_string_obj(lexem_t lx, pyobj_type type) {
+    size_t length;
+    const char *text = lexem_text(lx, &length);
+    char *buf = malloc(length + 1);
+    int n = 0;
+
+    assert(buf);
+    for (size_t i = 1; i + 1 < length; i++) {
+        char c = text[i];
+        if (c == '\\' && i + 2 < length) {
+            c = text[++i];
+            if (c == 'n') c = '\n';
+            else if (c == 't') c = '\t';
+            else if (c == 'r') c = '\r';
+            else if (c == 'x' && i + 3 < length) {
+                char hex[3] = { text[i + 1], text[i + 2], '\0' };
+                c = (char)strtol(hex, NULL, 16);
+                i += 2;
+            }
+            else if (c >= '0' && c <= '7') {
+                int val = c - '0';
+                for (int k = 0; k < 2 && i + 2 < length && text[i + 1] >= '0' && text[i + 1] <= '7'; k++)
+                    val = 8 * val + text[++i] - '0';
+                c = (char)val;
+            }
+            else if (c != '\\' && c != '\'' && c != '"') buf[n++] = '\\'; // séquence inconnue : gardée telle quelle
+        }
+        buf[n++] = c;
+    }
+    return new_bytes_obj(buf, n, type);
+}
+
 /* Alloue un pyobj de type INTEGER_NODE */
 static pyobj_t new_int_obj(int val, pyobj_type type) {
     pyobj_t obj = new_pyobj(type);
@@ -175,35 +100,69 @@ static pyobj_t new_float_obj(double val) {
     return obj;
 }
 
-/* Construit un pyobj liste contenant n enfants */
-static pyobj_t new_list_obj(pyobj_type type, int n) {
-    pyobj_t obj = new_pyobj(type);
-    obj->py.list.size = n;
-    if(n > 0) {
-        obj->py.list.value = calloc(n, sizeof(pyobj_t));
+/* Ajoute un enfant à la fin d'un pyobj liste : la place double quand
+   elle manque, les éléments sont rangés directement dans la liste */
+static void list_obj_push(pyobj_t list, pyobj_t item) {
+    if (list->py.list.size == list->py.list.capacity) {
+        list->py.list.capacity = list->py.list.capacity ? 2 * list->py.list.capacity : 8;
+        list->py.list.value = realloc(list->py.list.value, list->py.list.capacity * sizeof(pyobj_t));
+        assert(list->py.list.value);
     }
-    return obj;
+    list->py.list.value[list->py.list.size++] = item;
 }
 
+/* Étiquette d'un bloc .text, rangée à sa première apparition */
+typedef struct {
+    char    *name;
+    unsigned hash;
+    int      offset;   // position dans le bytecode, -1 tant qu'elle n'est pas posée
+} py_label;
+
+/* Argument de saut vers une étiquette, complété à la fin du bloc */
+typedef struct {
+    int label;         // indice dans les étiquettes
+    int pos;           // position de l'argument dans le bytecode
+    int relative;      // compté depuis l'instruction suivante
+    int extended;      // argument au-delà de 0xFFFF : précédé d'un EXTENDED_ARG
+} py_fixup;
+
+/* Assemblage d'un bloc .text : bytecode et table des lignes (lnotab) */
+typedef struct {
+    struct bytebuf code;
+    struct bytebuf lnotab;
+    int   firstlineno; // 0 : module, fixé par le premier .line
+    int   lineno;      // ligne courante
+    int   lineno_off;  // position dans le bytecode du dernier changement de ligne
+
+    py_label *labels;  // étiquettes du bloc, retrouvées par leur nom dans slots
+    int       nlabels, labels_size;
+    int      *slots;   // adressage ouvert : indice + 1 dans labels, 0 si vide
+    int       nslots;
+    py_fixup *fixups;  // sauts vers une étiquette, dans l'ordre du bytecode
+    int       nfixups, fixups_size;
+} py_assembly;
+
 /* Déclarations des sous-fonctions du parseur */
 
-static void   parse_eol_star(list_t *lexems);
-static int   parse_prologue(list_t *lexems, py_codeblock *codeblock);
-static int   parse_set_directives(list_t *lexems, py_codeblock *codeblock);
-static int   parse_set(list_t *lexems, char *set, py_codeblock *codeblock);
-static int   parse_interned_strings(list_t *lexems, py_codeblock *codeblock);
-static int   parse_constants(list_t *lexems, py_codeblock *codeblock);
-static int   parse_optional(list_t *lexems, char *opt, py_codeblock *codeblock); 
-static pyobj_t parse_constant(list_t *lexems);
-static pyobj_t parse_tuple_or_list(list_t *lexems);
-static pyobj_t parse_code(list_t *lexems, py_codeblock *codeblock);
-static int parse_assembly_line(list_t *lexems, char *code, int *count1, char *lnt, int *count2);
-static pyobj_t parse_function(list_t *lexems);
+static void   parse_eol_star(lexarray_t lexems);
+static int   parse_prologue(lexarray_t lexems, py_codeblock *codeblock);
+static int   parse_set_directives(lexarray_t lexems, py_codeblock *codeblock);
+static int   parse_set(lexarray_t lexems, int set, py_codeblock *codeblock);
+static int   parse_interned_strings(lexarray_t lexems, py_codeblock *codeblock);
+static int   parse_constants(lexarray_t lexems, py_codeblock *codeblock);
+static int   parse_optional(lexarray_t lexems, int opt, py_codeblock *codeblock); 
+static pyobj_t parse_constant(lexarray_t lexems);
+static pyobj_t parse_tuple_or_list(lexarray_t lexems);
+static pyobj_t parse_code(lexarray_t lexems, py_codeblock *codeblock);
+static int parse_assembly_line(lexarray_t lexems, py_assembly *a);
+static int resolve_labels(py_assembly *a);
+static void assembly_free(py_assembly *a);
+static pyobj_t parse_function(lexarray_t lexems);
 static void free_pyobj_rec(pyobj_t obj);
 
 /* Implémentation principale : parse() */
 
-pyobj_t parse(list_t *lexems) 
+pyobj_t parse(lexarray_t lexems) 
 {
     // 1) Créer l’objet racine PYS_NODE
     pyobj_t root = new_pyobj(CODE_MARKER);
@@ -230,265 +189,238 @@ pyobj_t parse(list_t *lexems)
     return root;
 }
 
-static int parse_optional(list_t *lexems, char *opt, py_codeblock *codeblock) {
-    if(next_lexem_is(lexems, opt)) {
-        lexem_advance(lexems);
+static int parse_optional(lexarray_t lexems, int opt, py_codeblock *codeblock) {
+    if(lexarray_next_is(lexems, opt)) {
+        lexarray_advance(lexems);
         parse_eol_star(lexems);
 
         pyobj_t opt_node = new_pyobj(SET_MARKER);
 
-        #define MAX_OPT 2048
-        pyobj_t strings[MAX_OPT];
-        int count = 0;
-
-        while(next_lexem_is(lexems, "string")) {
-            lexem_t lx = list_first(*lexems);
-            strings[count++] = new_string_obj(lexem_value(lx), STRING_MARKER);
-            if(count >= MAX_OPT) {
-                print_parse_error("Erreur: trop de chaînes optionnelles (ligne %d col %d)\n", lexems);
-                return 0;
-            }
-            lexem_advance(lexems);
+        while(lexarray_next_is(lexems, LX_STRING)) {
+            struct lexem lex;
+            lexem_t lx = lexarray_peek(lexems, &lex);
+            list_obj_push(opt_node, new_string_obj(lx, STRING_MARKER));
+            lexarray_advance(lexems);
             parse_eol_star(lexems);
         }
 
-        opt_node->py.list.size = count;
-        opt_node->py.list.value = calloc(count, sizeof(pyobj_t));
-        for(int i=0; i<count; i++) {
-            opt_node->py.list.value[i] = strings[i];
+        if (opt == LX_DIR_NAMES) codeblock->binary.content.names = opt_node;
+        else if (opt == LX_DIR_VARNAMES) {
+            codeblock->binary.content.varnames = opt_node;
+            codeblock->header.local_count = opt_node->py.list.size;
         }
-
-        if (!strcmp("dir::names", opt)) codeblock->binary.content.names = opt_node;
-        else if (!strcmp("dir::varnames", opt)) codeblock->binary.content.varnames = opt_node;
-        else if (!strcmp("dir::freevars", opt)) codeblock->binary.content.freevars = opt_node;
-        else if (!strcmp("dir::cellvars", opt)) codeblock->binary.content.cellvars = opt_node;
+        else if (opt == LX_DIR_FREEVARS) codeblock->binary.content.freevars = opt_node;
+        else if (opt == LX_DIR_CELLVARS) codeblock->binary.content.cellvars = opt_node;
     }
 
     return 1;
 }
 
 /* Consomme zéro ou plus "newline" */
-static void parse_eol_star(list_t *lexems) {
-    while(next_lexem_is(lexems, "newline") 
-       || next_lexem_is(lexems, "blank")
-       || next_lexem_is(lexems, "comment")) 
+static void parse_eol_star(lexarray_t lexems) {
+    while(lexarray_next_is(lexems, LX_NEWLINE) 
+       || lexarray_next_is(lexems, LX_BLANK)
+       || lexarray_next_is(lexems, LX_COMMENT)) 
     {
-        lexem_advance(lexems);
+        lexarray_advance(lexems);
     }
 }
 
 /* prologue = set-directives + interned-strings + constants 
 + [names] + [varnames] + [freevars] + [cellvars] */
-static int parse_prologue(list_t *lexems, py_codeblock *codeblock) {
+static int parse_prologue(lexarray_t lexems, py_codeblock *codeblock) {
     if (!parse_set_directives(lexems, codeblock)) return 0;
     if (!parse_interned_strings(lexems, codeblock)) return 0;
     if (!parse_constants(lexems, codeblock)) return 0;
-    if (!parse_optional(lexems, "dir::names", codeblock)) return 0;
-    if (!parse_optional(lexems, "dir::varnames", codeblock)) return 0;
-    if (!parse_optional(lexems, "dir::freevars", codeblock)) return 0;
-    if (!parse_optional(lexems, "dir::cellvars", codeblock)) return 0;
+    if (!parse_optional(lexems, LX_DIR_NAMES, codeblock)) return 0;
+    if (!parse_optional(lexems, LX_DIR_VARNAMES, codeblock)) return 0;
+    if (!parse_optional(lexems, LX_DIR_FREEVARS, codeblock)) return 0;
+    if (!parse_optional(lexems, LX_DIR_CELLVARS, codeblock)) return 0;
     return 1;
 }
 
 /* set-directives = set-version-pyvm + set-flags + set-filename 
 + set-name + set-stack-size + set-arg-count */
-static int parse_set_directives(list_t *lexems, py_codeblock *codeblock)
+static int parse_set_directives(lexarray_t lexems, py_codeblock *codeblock)
 {
-    if (!parse_set(lexems, "version_pyvm", codeblock)) return 0;
-    if (!parse_set(lexems, "flags", codeblock)) return 0;
-    if (!parse_set(lexems, "filename", codeblock)) return 0;
-    if (!parse_set(lexems, "name", codeblock)) return 0;
-    if (!parse_set(lexems, "stack_size", codeblock)) return 0;
-    if (!parse_set(lexems, "arg_count", codeblock)) return 0;
+    if (!parse_set(lexems, LX_VERSION_PYVM, codeblock)) return 0;
+    if (!parse_set(lexems, LX_FLAGS, codeblock)) return 0;
+    if (!parse_set(lexems, LX_FILENAME, codeblock)) return 0;
+    if (!parse_set(lexems, LX_NAME, codeblock)) return 0;
+    if (!parse_set(lexems, LX_STACK_SIZE, codeblock)) return 0;
+    if (!parse_set(lexems, LX_ARG_COUNT, codeblock)) return 0;
     return 1;
 }
 
 /* valable pour traiter set-version-pyvm, set-flags, 
 set-filename, set-name, set-stack-size et set-arg-count */
-static int parse_set(list_t *lexems, char *set, py_codeblock *codeblock)
+static int parse_set(lexarray_t lexems, int set, py_codeblock *codeblock)
 {
-    if(!next_lexem_is(lexems, "dir::set")) {
+    if(!lexarray_next_is(lexems, LX_DIR_SET)) {
         print_parse_error("Erreur: attendu 'dir::set' pour version_pyvm (ligne %d col %d)\n", lexems);
         return 0;
     }
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
 
-    if(!next_lexem_is(lexems, set)) {
+    if(!lexarray_next_is(lexems, set)) {
         print_parse_error("Erreur: nom de directive absent ou incorrect (ligne %d col %d)\n", lexems);
         return 0;
     }
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
 
-    if (!strcmp(set, "version_pyvm") 
-     || !strcmp(set, "stack_size") 
-     || !strcmp(set, "arg_count")) 
+    if (set == LX_VERSION_PYVM 
+     || set == LX_STACK_SIZE 
+     || set == LX_ARG_COUNT) 
     {
-        if(!next_lexem_is(lexems, "integer::dec")) {
+        if(!lexarray_next_is(lexems, LX_INTEGER_DEC)) {
             print_parse_error("Erreur: attendu 'integer::dec' (ligne %d col %d)\n", lexems);
             return 0;
         }
         {
-            int val = atoi(lexem_value(list_first(*lexems)));
-            if (!strcmp(set, "version_pyvm")) codeblock->version_pyvm = val;
-            else if (!strcmp(set, "stack_size")) codeblock->header.stack_size = val;
-            else if (!strcmp(set, "arg_count")) codeblock->header.arg_count = val;
+            struct lexem lex;
+            int val = atoi(lexem_value(lexarray_peek(lexems, &lex)));
+            if (set == LX_VERSION_PYVM) codeblock->version_pyvm = val;
+            else if (set == LX_STACK_SIZE) codeblock->header.stack_size = val;
+            else if (set == LX_ARG_COUNT) codeblock->header.arg_count = val;
         }
     }
-    else if (!strcmp(set, "name") 
-          || !strcmp(set, "filename")) 
+    else if (set == LX_NAME 
+          || set == LX_FILENAME) 
     {
-        if(!next_lexem_is(lexems, "string")) {
+        if(!lexarray_next_is(lexems, LX_STRING)) {
         print_parse_error("Erreur: attendu 'string' (ligne %d col %d)\n", lexems);
         return 0;
         }
         {
-            lexem_t lx = list_first(*lexems);
-            pyobj_t str = new_string_obj(lexem_value(lx), STRING_MARKER);
-            if (!strcmp(set, "filename")) codeblock->binary.trailer.filename = str;
-            else if (!strcmp(set, "name")) codeblock->binary.trailer.name = str;
+            struct lexem lex;
+            lexem_t lx = lexarray_peek(lexems, &lex);
+            pyobj_t str = new_string_obj(lx, STRING_MARKER);
+            if (set == LX_FILENAME) codeblock->binary.trailer.filename = str;
+            else if (set == LX_NAME) codeblock->binary.trailer.name = str;
         }
     }
     else {
-        if(!next_lexem_is(lexems, "integer::hex")) {
+        if(!lexarray_next_is(lexems, LX_INTEGER_HEX)) {
             print_parse_error("Erreur: attendu 'integer::hex' (ligne %d col %d)\n", lexems);
             return 0;
         }
         {
-            lexem_t lx = list_first(*lexems);
+            struct lexem lex;
+            lexem_t lx = lexarray_peek(lexems, &lex);
             int val = (int)strtol(lexem_value(lx), NULL, 16); /* Conversion hexadécimale */
             codeblock->header.flags = val;
         }
     }
 
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
     parse_eol_star(lexems);
 
     return 1;
 }
 
 /* interned-strings = {‘dir::interned’} eol ( {‘string’} eol )* */
-static int parse_interned_strings(list_t *lexems, py_codeblock *codeblock)
+static int parse_interned_strings(lexarray_t lexems, py_codeblock *codeblock)
 {
-    if(!next_lexem_is(lexems, "dir::interned")) {
+    if(!lexarray_next_is(lexems, LX_DIR_INTERNED)) {
         print_parse_error("Erreur: attendu 'dir::interned' (ligne %d col %d)\n", lexems);
         return 0;
     }
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
     parse_eol_star(lexems);
 
     pyobj_t interned_node = new_pyobj(SET_MARKER);
 
-    #define MAX_INTERNED 1024
-    pyobj_t strings[MAX_INTERNED];
-    int count = 0;
-
-    while(next_lexem_is(lexems, "string")) {
-        lexem_t lx = list_first(*lexems);
-        strings[count] = new_string_obj(lexem_value(lx), STRINGREF_MARKER);
-        count++;
-        if(count >= MAX_INTERNED) {
-            print_parse_error("Erreur: trop de chaînes internées (ligne %d col %d)\n", lexems);
-            return 0;
-        }
-        lexem_advance(lexems);
+    while(lexarray_next_is(lexems, LX_STRING)) {
+        struct lexem lex;
+        lexem_t lx = lexarray_peek(lexems, &lex);
+        list_obj_push(interned_node, new_string_obj(lx, STRINGREF_MARKER));
+        lexarray_advance(lexems);
         parse_eol_star(lexems);
     }
 
-    interned_node->py.list.size = count;
-    interned_node->py.list.value = calloc(count, sizeof(pyobj_t));
-    for(int i=0; i<count; i++) {
-        interned_node->py.list.value[i] = strings[i];
-    }
-
     codeblock->binary.content.interned = interned_node;
     return 1;
 }
 
 /* ---- constants = {‘dir::consts’} eol ( constant eol )* ---- */
-static int parse_constants(list_t *lexems, py_codeblock *codeblock)
+static int parse_constants(lexarray_t lexems, py_codeblock *codeblock)
 {
-    if(!next_lexem_is(lexems, "dir::consts")) {
+    if(!lexarray_next_is(lexems, LX_DIR_CONSTS)) {
         print_parse_error("Erreur: attendu 'dir::consts' (ligne %d col %d)\n", lexems);
         return 0;
     }
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
+    if(!lexarray_next_is(lexems, LX_NEWLINE)) {
+        print_parse_error("Erreur: attendu 'newline' après 'dir::consts' (ligne %d col %d)\n", lexems);
+        return 0;
+    }
     parse_eol_star(lexems);
 
-    #define MAX_CONSTS 1024
-    pyobj_t csts[MAX_CONSTS];
-    int count = 0;
+    pyobj_t constants_node = new_pyobj(SET_MARKER);
+    codeblock->binary.content.consts = constants_node;
 
     while(
-       next_lexem_is(lexems, "integer")     /* integer::dec OU integer::hex */
-    || next_lexem_is(lexems, "float")
-    || next_lexem_is(lexems, "string")
-    || next_lexem_is(lexems, "pycst")
-    || next_lexem_is(lexems, "paren::left")
- //   || next_lexem_is(lexems, "brack::left")
-    || next_lexem_is(lexems, "dir::code_start")
+       lexarray_next_is(lexems, LX_INTEGER)     /* integer::dec OU integer::hex */
+    || lexarray_next_is(lexems, LX_FLOAT)
+    || lexarray_next_is(lexems, LX_STRING)
+    || lexarray_next_is(lexems, LX_PYCST)
+    || lexarray_next_is(lexems, LX_PAREN_LEFT)
+ //   || lexarray_next_is(lexems, LX_BRACK_LEFT)
+    || lexarray_next_is(lexems, LX_DIR_CODE_START)
     )
     {
         pyobj_t cst = parse_constant(lexems);
-        csts[count++] = cst;
-        if(count >= MAX_CONSTS) {
-            print_parse_error("Erreur: trop de constantes (ligne %d col %d)\n", lexems);
-            return 0;
-        }
+        if (!cst) return 0;
+        list_obj_push(constants_node, cst);
         parse_eol_star(lexems);
     }
 
-    pyobj_t constants_node = new_pyobj(SET_MARKER);
-    constants_node->py.list.size = count;
-    constants_node->py.list.value = calloc(count, sizeof(pyobj_t));
-    for(int i=0; i<count; i++) {
-        constants_node->py.list.value[i] = csts[i];
-    }
-
-    codeblock->binary.content.consts = constants_node;
     return 1;
 }
 
 /* ---- constant = {‘integer’} | {‘float’} | {‘string’} | {‘pycst’} | tuple ---- */
-static pyobj_t parse_constant(list_t *lexems)
+static pyobj_t parse_constant(lexarray_t lexems)
 {
-    /* Au lieu de lexem_peek(...)->type, on utilise next_lexem_is() */
-    if(next_lexem_is(lexems, "integer")) {
+    /* Au lieu de lexem_peek(...)->type, on utilise lexarray_next_is() */
+    if(lexarray_next_is(lexems, LX_INTEGER)) {
         /* integer::dec ou integer::hex => on regarde plus précisément */
-        lexem_t lx = list_first(*lexems);
+        struct lexem lex;
+        lexem_t lx = lexarray_peek(lexems, &lex);
         int val;
     
-        if(next_lexem_is(lexems, "integer::hex")) val = (int)strtol(lexem_value(lx), NULL, 16);
+        if(lexarray_next_is(lexems, LX_INTEGER_HEX)) val = (int)strtol(lexem_value(lx), NULL, 16);
         else val = (int)strtol(lexem_value(lx), NULL, 10);
 
-        lexem_advance(lexems);
+        lexarray_advance(lexems);
         return new_int_obj(val, INT_MARKER);
     }
-    else if(next_lexem_is(lexems, "float")) {
-        lexem_t lx = list_first(*lexems);
+    else if(lexarray_next_is(lexems, LX_FLOAT)) {
+        struct lexem lex;
+        lexem_t lx = lexarray_peek(lexems, &lex);
         double val = atof(lexem_value(lx));
-        lexem_advance(lexems);
+        lexarray_advance(lexems);
         return new_float_obj(val);
     }
-    else if(next_lexem_is(lexems, "string")) {
-        lexem_t lx = list_first(*lexems);
-        char* str = lexem_value(lx);
-        pyobj_t pobj = new_string_obj(str, STRING_MARKER);
-        lexem_advance(lexems);
+    else if(lexarray_next_is(lexems, LX_STRING)) {
+        struct lexem lex;
+        lexem_t lx = lexarray_peek(lexems, &lex);
+        pyobj_t pobj = new_string_obj(lx, STRING_MARKER);
+        lexarray_advance(lexems);
         return pobj;
     }
-    else if(next_lexem_is(lexems, "pycst")) {
+    else if(lexarray_next_is(lexems, LX_PYCST)) {
         pyobj_type type = 0;
-        if (next_lexem_is(lexems, "pycst::None")) type = NONE_MARKER;
-        if (next_lexem_is(lexems, "pycst::True")) type = TRUE_MARKER;
-        if (next_lexem_is(lexems, "pycst::False")) type = FALSE_MARKER;
+        if (lexarray_next_is(lexems, LX_PYCST_NONE)) type = NONE_MARKER;
+        if (lexarray_next_is(lexems, LX_PYCST_TRUE)) type = TRUE_MARKER;
+        if (lexarray_next_is(lexems, LX_PYCST_FALSE)) type = FALSE_MARKER;
         pyobj_t obj = new_pyobj(type);
-        lexem_advance(lexems);
+        lexarray_advance(lexems);
         return obj;
     }
-    else if(next_lexem_is(lexems, "paren::left") || next_lexem_is(lexems, "brack::left")) {
+    else if(lexarray_next_is(lexems, LX_PAREN_LEFT) || lexarray_next_is(lexems, LX_BRACK_LEFT)) {
         return parse_tuple_or_list(lexems);
     }
-    else if(next_lexem_is(lexems, "dir::code_start")) {
+    else if(lexarray_next_is(lexems, LX_DIR_CODE_START)) {
         return parse_function(lexems);
     }
 
@@ -497,124 +429,372 @@ static pyobj_t parse_constant(list_t *lexems)
 }
 
 /* tuple = {‘paren::left’} ({’blank’} constant )* {‘paren::right’} */
-static pyobj_t parse_tuple_or_list(list_t *lexems)
+static pyobj_t parse_tuple_or_list(lexarray_t lexems)
 {
     int par = 0;
-    if (next_lexem_is(lexems, "paren::left")) par = 1;
-    else if (!next_lexem_is(lexems, "brack::left")) {
+    if (lexarray_next_is(lexems, LX_PAREN_LEFT)) par = 1;
+    else if (!lexarray_next_is(lexems, LX_BRACK_LEFT)) {
         print_parse_error("Erreur: attendu '[' ou '(' (ligne %d col %d)\n", lexems);
         return NULL;
     }
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
 
-    #define MAX_TUPLE_ELTS 2048
-    pyobj_t elts[MAX_TUPLE_ELTS];
-    int count = 0;
+    pyobj_t tuple_obj = new_pyobj(par ? TUPLE_MARKER : LIST_MARKER);
 
     while(1) {
-        if( next_lexem_is(lexems, "integer")
-         || next_lexem_is(lexems, "float")
-         || next_lexem_is(lexems, "string")
-         || next_lexem_is(lexems, "pycst")
-         || next_lexem_is(lexems, "paren::left") )
+        if( lexarray_next_is(lexems, LX_INTEGER)
+         || lexarray_next_is(lexems, LX_FLOAT)
+         || lexarray_next_is(lexems, LX_STRING)
+         || lexarray_next_is(lexems, LX_PYCST)
+         || lexarray_next_is(lexems, LX_PAREN_LEFT) )
         {
-            elts[count++] = parse_constant(lexems);
-            if(count >= MAX_TUPLE_ELTS) {
-                print_parse_error("Erreur: tuple trop gros (ligne %d col %d)\n", lexems);
+            pyobj_t elt = parse_constant(lexems);
+            if (!elt) {
+                free_pyobj(tuple_obj);
                 return NULL;
             }
+            list_obj_push(tuple_obj, elt);
         }
         else {
             break;
         }
     }
 
-    if(par == 1 && !next_lexem_is(lexems, "paren::right")) {
+    if(par == 1 && !lexarray_next_is(lexems, LX_PAREN_RIGHT)) {
         print_parse_error("Erreur: attendu ')' (fin de tuple) (ligne %d col %d)\n", lexems);
+        free_pyobj(tuple_obj);
         return NULL;
     }
-    /*else if (!next_lexem_is(lexems, "brack::right")) {
+    /*else if (!lexarray_next_is(lexems, LX_BRACK_RIGHT)) {
         print_parse_error("Erreur: attendu ']' (fin de tuple) (ligne %d col %d)\n", lexems);
         return NULL;
     }*/
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
 
-    pyobj_type type;
-    if (par) type = TUPLE_MARKER;
-    else type = LIST_MARKER;
-    pyobj_t tuple_obj = new_list_obj(type, count);
-    for(int i=0; i<count; i++) {
-        tuple_obj->py.list.value[i] = elts[i];
-    }
     return tuple_obj;
 }
 
 /* code = {‘dir::text’} eol ( assembly-line eol )* */
-static pyobj_t parse_code(list_t *lexems, py_codeblock *codeblock)
+static pyobj_t parse_code(lexarray_t lexems, py_codeblock *codeblock)
 {
-    if(!next_lexem_is(lexems, "dir::text")) {
+    if(!lexarray_next_is(lexems, LX_DIR_TEXT)) {
         print_parse_error("Erreur: attendu 'dir::text' pour le code (ligne %d col %d)\n", lexems);
         return NULL;
     }
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
     parse_eol_star(lexems);
 
-    char code[100000] = {0};
-    char lnt[100000] = {0};
-
-    int count1 = 0;
-    int count2 = 0;
+    /* Au plus 3 octets par instruction et, le plus souvent, 2 octets de
+       lnotab par .line : comptés d'avance (en partie avec lex_stream),
+       le bytecode est rarement recopié */
+    py_assembly a;
+    memset(&a, 0, sizeof(a));
+    a.firstlineno = a.lineno = codeblock->binary.trailer.firstlineno;
+    static const int counted[2] = { LX_INSN, LX_DIR_LINE };
+    size_t counts[2];
+    lexarray_count(lexems, LX_DIR_CODE_END, 2, counted, counts);
+    bytebuf_init(&a.code, 3 * counts[0]);
+    bytebuf_init(&a.lnotab, 2 * counts[1]);
+    int lines = 0;
 
     while(
-       next_lexem_is(lexems, "insn::0")
-    || next_lexem_is(lexems, "insn::1")
-    || next_lexem_is(lexems, "dir::line")
-    || next_lexem_is(lexems, "symbol")
+       lexarray_next_is(lexems, LX_INSN_0)
+    || lexarray_next_is(lexems, LX_INSN_1)
+    || lexarray_next_is(lexems, LX_DIR_LINE)
+    || lexarray_next_is(lexems, LX_SYMBOL)
     )
     {
         parse_eol_star(lexems);
-        if(!parse_assembly_line(lexems, code, &count1, lnt, &count2)) return NULL;
-        lexem_advance(lexems);
+        if(!parse_assembly_line(lexems, &a)) {
+            assembly_free(&a);
+            return NULL;
+        }
+        lexarray_advance(lexems);
+        lines++;
     }
 
-    if (!count1 && !count2) {
+    if (!lines) {
         print_parse_error("Erreur: attendu <assembly_line> pour le code (ligne %d col %d)\n", lexems);
+        assembly_free(&a);
         return NULL;
     }
-    pyobj_t code_obj = new_string_obj(code, STRING_MARKER);
-    codeblock->binary.trailer.lnotab = new_string_obj(lnt, STRING_MARKER);
+    if (!resolve_labels(&a)) {
+        assembly_free(&a);
+        return NULL;
+    }
+    codeblock->binary.trailer.firstlineno = a.firstlineno ? a.firstlineno : 1;
+    pyobj_t code_obj = new_bytebuf_obj(&a.code, STRING_MARKER);
+    codeblock->binary.trailer.lnotab = new_bytebuf_obj(&a.lnotab, STRING_MARKER);
+    assembly_free(&a); // reste les étiquettes : bytecode et lnotab sont repris
     return code_obj;
 }
 
+/* Ajoute un couple (octets de bytecode, lignes) à la lnotab */
+static void lnotab_add(py_assembly *a, int d_code, int d_line) {
+    bytebuf_put_byte(&a->lnotab, d_code);
+    bytebuf_put_byte(&a->lnotab, d_line);
+}
+
+/* Changement de ligne à la position 'offset' du bytecode, codé comme
+   assemble_lnotab() de Python 2.7 : écarts de 255 au plus, rien si la
+   ligne ne change pas */
+static void lnotab_line(py_assembly *a, int offset, int lineno) {
+    int d_code = offset - a->lineno_off;
+    int d_line = lineno - a->lineno;
+
+    if (!d_line) return;
+    for (; d_code > 255; d_code -= 255) lnotab_add(a, 255, 0);
+    if (d_line > 255) {
+        lnotab_add(a, d_code, 255);
+        d_code = 0;
+        for (d_line -= 255; d_line > 255; d_line -= 255) lnotab_add(a, 0, 255);
+    }
+    lnotab_add(a, d_code, d_line);
+    a->lineno = lineno;
+    a->lineno_off = offset;
+}
+
+/* Libère ce qui reste d'un assemblage (tout, s'il a échoué) */
+static void assembly_free(py_assembly *a) {
+    for (int i = 0; i < a->nlabels; i++) free(a->labels[i].name);
+    free(a->labels);
+    free(a->slots);
+    free(a->fixups);
+    bytebuf_free(&a->code);
+    bytebuf_free(&a->lnotab);
+}
+
+/* Indice de l'étiquette 'name' ('length' octets), ajoutée non posée si
+   elle n'existe pas encore : table de hachage, O(1) en moyenne */
+static int label_index(py_assembly *a, const char *name, size_t length) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+
+    /* Au plus à moitié pleine : on double et on replace les étiquettes */
+    if (2 * (a->nlabels + 1) > a->nslots) {
+        a->nslots = a->nslots ? 2 * a->nslots : 64;
+        free(a->slots);
+        a->slots = calloc(a->nslots, sizeof(int));
+        assert(a->slots);
+        for (int i = 0; i < a->nlabels; i++) {
+            unsigned h = a->labels[i].hash;
+            while (a->slots[h & (a->nslots - 1)]) h++;
+            a->slots[h & (a->nslots - 1)] = i + 1;
+        }
+    }
+
+    for (unsigned h = hash;; h++) {
+        int *slot = &a->slots[h & (a->nslots - 1)];
+        if (*slot) {
+            py_label *l = &a->labels[*slot - 1];
+            if (l->hash == hash && !strncmp(l->name, name, length) && !l->name[length]) return *slot - 1;
+            continue;
+        }
+        if (a->nlabels == a->labels_size) {
+            a->labels_size = a->labels_size ? 2 * a->labels_size : 64;
+            a->labels = realloc(a->labels, a->labels_size * sizeof(py_label));
+            assert(a->labels);
+        }
+        py_label *l = &a->labels[a->nlabels];
+        l->name = malloc(length + 1);
+        assert(l->name);
+        memcpy(l->name, name, length);
+        l->name[length] = '\0';
+        l->hash = hash;
+        l->offset = -1;
+        *slot = ++a->nlabels;
+        return a->nlabels - 1;
+    }
+}
+
+/* Préfixe des arguments au-delà de 0xFFFF : il en porte les 16 bits de poids fort */
+#define EXTENDED_ARG 145
+
+/* Sauts de Python 2.7 dont l'argument est une position dans le bytecode */
+enum { NO_JUMP, JUMP_REL, JUMP_ABS };
+
+static int jump_kind(int opcode) {
+    switch (opcode) {
+    case 93:  // FOR_ITER
+    case 110: // JUMP_FORWARD
+    case 120: // SETUP_LOOP
+    case 121: // SETUP_EXCEPT
+    case 122: // SETUP_FINALLY
+    case 143: // SETUP_WITH
+        return JUMP_REL;
+    case 111: // JUMP_IF_FALSE_OR_POP
+    case 112: // JUMP_IF_TRUE_OR_POP
+    case 113: // JUMP_ABSOLUTE
+    case 114: // POP_JUMP_IF_FALSE
+    case 115: // POP_JUMP_IF_TRUE
+    case 119: // CONTINUE_LOOP
+        return JUMP_ABS;
+    default:
+        return NO_JUMP;
+    }
+}
+
+/* Position 'offset' du bytecode une fois les sauts 'extended' précédés
+   de leur EXTENDED_ARG : before[i] est le décalage (3 octets par saut
+   allongé) de tout ce qui suit le début du saut i */
+static int shifted(py_assembly *a, const int *before, int offset) {
+    int lo = 0, hi = a->nfixups;
+    while (lo < hi) { // premier saut qui ne commence pas avant offset
+        int mid = (lo + hi) / 2;
+        if (a->fixups[mid].pos - 1 < offset) lo = mid + 1;
+        else hi = mid;
+    }
+    return offset + before[lo];
+}
+
+/* Argument du saut i avec les décalages 'before' */
+static int fixup_arg(py_assembly *a, const int *before, int i) {
+    py_fixup *f = &a->fixups[i];
+    int target = shifted(a, before, a->labels[f->label].offset);
+    /* Relatif : depuis la fin de l'instruction (opcode + 2 octets) */
+    int end = f->pos + before[i] + (f->extended ? 3 : 0) + 2;
+    return f->relative ? target - end : target;
+}
+
+/* Insère un EXTENDED_ARG (complété avec l'argument) avant chaque saut
+   allongé, et refait la lnotab avec les positions décalées */
+static void relocate(py_assembly *a, const int *before) {
+    struct bytebuf code;
+    size_t from = 0;
+    bytebuf_init(&code, a->code.size + before[a->nfixups]);
+    for (int i = 0; i < a->nfixups; i++) {
+        if (!a->fixups[i].extended) continue;
+        size_t start = a->fixups[i].pos - 1;
+        bytebuf_put(&code, a->code.data + from, start - from);
+        bytebuf_put(&code, "\0\0\0", 3);
+        from = start;
+    }
+    bytebuf_put(&code, a->code.data + from, a->code.size - from);
+    bytebuf_free(&a->code);
+    a->code = code;
+
+    /* Mêmes changements de ligne, relus dans l'ancienne lnotab */
+    struct bytebuf lnotab = a->lnotab;
+    int offset = 0, lineno = a->firstlineno;
+    bytebuf_init(&a->lnotab, lnotab.size);
+    a->lineno = a->firstlineno;
+    a->lineno_off = 0;
+    for (size_t k = 0; k + 1 < lnotab.size; k += 2) {
+        offset += (unsigned char)lnotab.data[k];
+        lineno += (unsigned char)lnotab.data[k + 1];
+        if (lnotab.data[k + 1]) lnotab_line(a, shifted(a, before, offset), lineno);
+    }
+    bytebuf_free(&lnotab);
+}
+
+/*
+  Complète les arguments des sauts, une fois toutes les étiquettes du
+  bloc posées. Un saut dont l'argument dépasse 0xFFFF prend un
+  EXTENDED_ARG : ce qui le suit est décalé de 3 octets, ce qui peut en
+  allonger d'autres. On recommence jusqu'à ce qu'aucun ne s'allonge plus
+  (un saut allongé le reste), puis le bytecode n'est recopié qu'une fois.
+  Sans saut allongé, un seul parcours et rien n'est recopié.
+*/
+static int resolve_labels(py_assembly *a) {
+    for (int i = 0; i < a->nfixups; i++) {
+        py_label *l = &a->labels[a->fixups[i].label];
+        if (l->offset < 0) {
+            fprintf(stderr, "Erreur: étiquette '%s' jamais posée dans le bloc .text\n", l->name);
+            return 0;
+        }
+    }
+
+    int *before = calloc(a->nfixups + 1, sizeof(int));
+    assert(before);
+    int grown;
+    do {
+        for (int i = 0; i < a->nfixups; i++)
+            before[i + 1] = before[i] + (a->fixups[i].extended ? 3 : 0);
+        grown = 0;
+        for (int i = 0; i < a->nfixups; i++)
+            if (!a->fixups[i].extended && fixup_arg(a, before, i) > 0xFFFF) {
+                a->fixups[i].extended = 1;
+                grown = 1;
+            }
+    } while (grown);
+    if (before[a->nfixups]) relocate(a, before);
+
+    for (int i = 0; i < a->nfixups; i++) {
+        py_fixup *f = &a->fixups[i];
+        int arg = fixup_arg(a, before, i);
+        if (arg < 0) {
+            fprintf(stderr, "Erreur: saut vers l'étiquette '%s' hors de portée (%d)\n", a->labels[f->label].name, arg);
+            free(before);
+            return 0;
+        }
+        unsigned char *p = (unsigned char *)a->code.data + f->pos + before[i] + (f->extended ? 3 : 0);
+        if (f->extended) {
+            p[-4] = EXTENDED_ARG; // p[-1] est l'opcode du saut
+            p[-3] = (arg >> 16) & 0xFF;
+            p[-2] = (arg >> 24) & 0xFF;
+        }
+        p[0] = arg & 0xFF;
+        p[1] = (arg >> 8) & 0xFF;
+    }
+    free(before);
+    return 1;
+}
+
 /* assembly-line = insn | source-lineno | label */
-static int parse_assembly_line(list_t *lexems, char *code, int *count1, char *lnt, int *count2)
+static int parse_assembly_line(lexarray_t lexems, py_assembly *a)
 {
     /* insn */
-    if(next_lexem_is(lexems, "insn::0") || next_lexem_is(lexems, "insn::1")) {
-        lexem_t lx_insn = list_first(*lexems);
-        int opcode = (int)strtol(lexem_value(lx_insn), NULL, 16);
-        char *ptr1 = (char*)&opcode;
-        code[*count1] = ptr1[0];
-        (*count1)++;
+    if(lexarray_next_is(lexems, LX_INSN_0) || lexarray_next_is(lexems, LX_INSN_1)) {
+        struct lexem insn;
+        lexem_t lx_insn = lexarray_peek(lexems, &insn);
+        int opcode = lexem_opcode(lx_insn);
         /* si c’est insn::1 => un argument suit */
-        if( lexem_type(lx_insn, "insn::1") ) {
-            lexem_advance(lexems);
-
-            if(next_lexem_is(lexems, "integer::dec")) {
-                lexem_t lx_arg = list_first(*lexems);
-                int arg_val = atoi(lexem_value(lx_arg));
-                char *ptr2 = (char*)&arg_val;
-                code[*count1] = ptr2[0];
-                (*count1)++;
-                code[*count1] = ptr2[1];
-                (*count1)++;
-                // printf( "%d -> %02x %02x %02x %02x\n", arg_val, ptr[0], ptr[1], ptr[2], ptr[3] );
-                lexem_advance(lexems);
+        if( lexem_arity(lx_insn) == 1 ) {
+            lexarray_advance(lexems);
+
+            if(lexarray_next_is(lexems, LX_INTEGER_DEC)) {
+                struct lexem arg;
+                lexem_t lx_arg = lexarray_peek(lexems, &arg);
+                long arg_val = strtol(lexem_value(lx_arg), NULL, 10);
+                if (arg_val > 0x7FFFFFFF) {
+                    print_parse_error("Erreur: argument d'instruction hors de portée (ligne %d col %d)\n", lexems);
+                    return 0;
+                }
+                /* Au-delà de 0xFFFF : les 16 bits de poids fort dans un EXTENDED_ARG */
+                if (arg_val > 0xFFFF) {
+                    bytebuf_put_byte(&a->code, EXTENDED_ARG);
+                    bytebuf_put_byte(&a->code, (arg_val >> 16) & 0xFF);
+                    bytebuf_put_byte(&a->code, (arg_val >> 24) & 0xFF);
+                }
+                bytebuf_put_byte(&a->code, opcode);
+                bytebuf_put_byte(&a->code, arg_val & 0xFF); // argument sur 2 octets, petit-boutiste
+                bytebuf_put_byte(&a->code, (arg_val >> 8) & 0xFF);
+                lexarray_advance(lexems);
                 return 1;
             }
-            else if(next_lexem_is(lexems, "symbol")) {
-                //print_parse_error("Erreur: insn::1 attend un entier (dec) mais pas un symbol car on utilise --easy (ligne %d col %d)\n", lexems);
-                //return 0;
+            else if(lexarray_next_is(lexems, LX_SYMBOL)) {
+                int kind = jump_kind(opcode);
+                if (kind == NO_JUMP) {
+                    print_parse_error("Erreur: étiquette en argument d'une instruction qui n'est pas un saut (ligne %d col %d)\n", lexems);
+                    return 0;
+                }
+                size_t length;
+                struct lexem lex;
+                const char *name = lexem_text(lexarray_peek(lexems, &lex), &length);
+                if (a->nfixups == a->fixups_size) {
+                    a->fixups_size = a->fixups_size ? 2 * a->fixups_size : 64;
+                    a->fixups = realloc(a->fixups, a->fixups_size * sizeof(py_fixup));
+                    assert(a->fixups);
+                }
+                bytebuf_put_byte(&a->code, opcode);
+                py_fixup *f = &a->fixups[a->nfixups++];
+                f->label = label_index(a, name, length);
+                f->pos = (int)a->code.size;
+                f->relative = (kind == JUMP_REL);
+                f->extended = 0;
+                bytebuf_put_byte(&a->code, 0); // complété par resolve_labels()
+                bytebuf_put_byte(&a->code, 0);
+                lexarray_advance(lexems);
                 return 1;
             }
             else {
@@ -623,37 +803,51 @@ static int parse_assembly_line(list_t *lexems, char *code, int *count1, char *ln
             }
         }
         else {
-            lexem_advance(lexems);
+            bytebuf_put_byte(&a->code, opcode);
+            lexarray_advance(lexems);
             return 1;
         }
     }
     /* source-lineno */
-    else if(next_lexem_is(lexems, "dir::line")) {
-        lexem_advance(lexems);
+    else if(lexarray_next_is(lexems, LX_DIR_LINE)) {
+        lexarray_advance(lexems);
 
-        if(!next_lexem_is(lexems, "integer::dec")) {
+        if(!lexarray_next_is(lexems, LX_INTEGER_DEC)) {
             print_parse_error("Erreur: attendu 'integer::dec' après 'dir::line' (ligne %d col %d)\n", lexems);
             return 0;
         }
-        lexem_t lx_num = list_first(*lexems);
-        int lineno; 
-        if (!(*count2)) lineno = atoi(lexem_value(lx_num));
-        else lineno = atoi(lexem_value(lx_num)) - lnt[*count2 - 1];
-        char *ptr3 = (char*)&lineno;
-        lnt[*count2] = ptr3[0];
-        (*count2)++;
-        lexem_advance(lexems);
+        struct lexem num;
+        lexem_t lx_num = lexarray_peek(lexems, &num);
+        int lineno = atoi(lexem_value(lx_num));
+        /* Module : sa première ligne est celle de sa première instruction */
+        if (!a->lineno) a->firstlineno = a->lineno = lineno;
+        if (lineno < a->lineno) {
+            print_parse_error("Erreur: numéro de ligne inférieur au précédent (ligne %d col %d)\n", lexems);
+            return 0;
+        }
+        lnotab_line(a, (int)a->code.size, lineno);
+        lexarray_advance(lexems);
         return 1;
     }
     /* label => symbol blank colon */
-    else if(next_lexem_is(lexems, "symbol")) {
-        lexem_advance(lexems);
+    else if(lexarray_next_is(lexems, LX_SYMBOL)) {
+        size_t length;
+        struct lexem lex;
+        const char *name = lexem_text(lexarray_peek(lexems, &lex), &length);
+        int index = label_index(a, name, length); // peut agrandir a->labels
+        py_label *l = &a->labels[index];
+        if (l->offset >= 0) {
+            print_parse_error("Erreur: étiquette déjà posée dans ce bloc (ligne %d col %d)\n", lexems);
+            return 0;
+        }
+        l->offset = (int)a->code.size;
+        lexarray_advance(lexems);
 
-        if(!next_lexem_is(lexems, "colon")) {
+        if(!lexarray_next_is(lexems, LX_COLON)) {
             print_parse_error("Erreur: attendu ':' après un 'symbol' (ligne %d col %d)\n", lexems);
             return 0;
         }
-        lexem_advance(lexems);
+        lexarray_advance(lexems);
         return 1;
     }
     else {
@@ -663,22 +857,24 @@ static int parse_assembly_line(list_t *lexems, char *code, int *count1, char *ln
 }
 
 /* function = {‘dir::code_start’} {‘integer’} ⟨eol⟩ ⟨pys⟩ {‘dir::code_end’} */
-static pyobj_t parse_function(list_t *lexems) {
-    if (!next_lexem_is(lexems, "dir::code_start")) {
+static pyobj_t parse_function(lexarray_t lexems) {
+    if (!lexarray_next_is(lexems, LX_DIR_CODE_START)) {
         print_parse_error("Erreur: attendu 'dir::code_start' pour la fonction (ligne %d col %d)\n", lexems);
         return NULL;
     }
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
 
-    if (!next_lexem_is(lexems, "integer")) {
+    if (!lexarray_next_is(lexems, LX_INTEGER)) {
         print_parse_error("Erreur: attendu 'integer' après 'dir::code_start' (ligne %d col %d)\n", lexems);
         return NULL;
     }
 
     int func_id = 0;
     {
-        lexem_t lx = lexem_advance(lexems);
+        struct lexem lex;
+        lexem_t lx = lexarray_peek(lexems, &lex);
         func_id = atoi(lexem_value(lx));
+        lexarray_advance(lexems);
     }
     parse_eol_star(lexems);
 
@@ -691,16 +887,16 @@ static pyobj_t parse_function(list_t *lexems) {
     if (!parse_set_directives(lexems, cb)) return NULL;
 
     // 7) [⟨interned-strings⟩] => facultatif lorsque l'on est entre .code_start et .code_end
-    if (next_lexem_is(lexems, "dir::interned")) {
+    if (lexarray_next_is(lexems, LX_DIR_INTERNED)) {
         if (!parse_interned_strings(lexems, cb)) return NULL;
     }
 
     if (!parse_constants(lexems, cb)) return NULL;
 
-    if (!parse_optional(lexems, "dir::names",    cb)) return NULL;
-    if (!parse_optional(lexems, "dir::varnames", cb)) return NULL;
-    if (!parse_optional(lexems, "dir::freevars", cb)) return NULL;
-    if (!parse_optional(lexems, "dir::cellvars", cb)) return NULL;
+    if (!parse_optional(lexems, LX_DIR_NAMES,    cb)) return NULL;
+    if (!parse_optional(lexems, LX_DIR_VARNAMES, cb)) return NULL;
+    if (!parse_optional(lexems, LX_DIR_FREEVARS, cb)) return NULL;
+    if (!parse_optional(lexems, LX_DIR_CELLVARS, cb)) return NULL;
 
     {
         pyobj_t code_obj = parse_code(lexems, cb); 
@@ -708,11 +904,11 @@ static pyobj_t parse_function(list_t *lexems) {
         cb->binary.content.bytecode = code_obj;
     }
 
-    if (!next_lexem_is(lexems, "dir::code_end")) {
+    if (!lexarray_next_is(lexems, LX_DIR_CODE_END)) {
         print_parse_error("Erreur: attendu 'dir::code_end' à la fin de la fonction (ligne %d col %d)\n", lexems);
         return NULL;
     }
-    lexem_advance(lexems);
+    lexarray_advance(lexems);
     parse_eol_star(lexems);
 
     return func_node;
@@ -833,6 +1029,17 @@ static void print_codeblock(py_codeblock *cb, int indent_level)
     print_pyobj_rec(cb->binary.content.bytecode, indent_level + 1);
 }
 
+/* Octets d'une chaîne, sur sa longueur : ceux qui ne s'affichent pas
+   (bytecode, lnotab, '\0') en \xHH */
+static void print_bytes(pyobj_t obj)
+{
+    for (int i = 0; i < obj->py.string.length; i++) {
+        unsigned char c = (unsigned char)obj->py.string.buffer[i];
+        if (c < ' ' || c == 0x7f || c == '\\') printf("\\x%02x", c);
+        else putchar(c);
+    }
+}
+
 /**
  * Fonction récursive d’affichage d’un pyobj_t.
  */
@@ -873,15 +1080,15 @@ static void print_pyobj_rec(pyobj_t obj, int indent_level)
 
         case STRING_MARKER:
             /* On affiche la chaîne */
-            printf("%sSTRING(%s)%s\n", col, 
-                   (obj->py.string.buffer ? obj->py.string.buffer : ""), 
-                   COLOR_RESET);
+            printf("%sSTRING(", col);
+            print_bytes(obj);
+            printf(")%s\n", COLOR_RESET);
             break;
 
         case STRINGREF_MARKER:
-            printf("%sSTRINGREF(%s)%s\n", col,
-                   (obj->py.string.buffer ? obj->py.string.buffer : ""),
-                   COLOR_RESET);
+            printf("%sSTRINGREF(", col);
+            print_bytes(obj);
+            printf(")%s\n", COLOR_RESET);
             break;
 
         case TUPLE_MARKER:
@@ -947,7 +1154,7 @@ static void free_pyobj_rec(pyobj_t obj) {
     if (!obj) return;
 
     /* 1) Si obj->py.list.value n'est pas NULL, libérer récursivement chaque enfant */
-    if (obj->type == SET_MARKER && obj->py.list.size > 0){
+    if ((obj->type == SET_MARKER || obj->type == TUPLE_MARKER || obj->type == LIST_MARKER) && obj->py.list.value){
         for (int i = 0; i < obj->py.list.size; i++) {
             free_pyobj_rec(obj->py.list.value[i]);
         }
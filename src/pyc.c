@@ -0,0 +1,256 @@
+/**
+ * @file pyc.c
+ * @author François Cayre <francois.cayre@grenoble-inp.fr>
+ * @brief Écriture des fichiers .pyc.
+ *
+ * Tout le fichier est construit dans un seul tableau qui double quand il
+ * est plein, puis écrit d'un coup : pas de petite écriture par objet.
+ *
+ * Comme marshal.dump() de Python 2.7, une chaîne internée est écrite en
+ * entier la première fois ('t'), puis par son numéro d'apparition ('R').
+ * Les chaînes internées sont celles de la directive .interned, retrouvées
+ * par une table de hachage. Le bytecode et la lnotab ne sont jamais
+ * internés, sauf s'ils font au plus un octet : Python partage alors une
+ * seule chaîne de ce contenu, internée si elle l'a été ailleurs.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <pyas/pyc.h>
+#include <pyas/pyobj.h>
+#include <pyas/bytebuf.h>
+
+/* Marqueur des .pyc : numéro de version de la machine virtuelle, puis "\r\n" */
+#define PYC_MAGIC( version ) ( ( (version) & 0xFFFF ) | ( '\r' << 16 ) | ( '\n' << 24 ) )
+
+struct interned {
+  const char *string; /* NULL : case vide */
+  int         length;
+  int         ref;    /* numéro de 'R', -1 tant qu'elle n'est pas écrite */
+};
+
+struct pyc_writer {
+  struct bytebuf   out;
+
+  struct interned *interned; /* adressage ouvert, taille puissance de 2 */
+  int              nslots;
+  int              count;
+  int              refs;     /* chaînes déjà écrites avec 't' */
+};
+
+static void put_bytes( struct pyc_writer *w, const void *bytes, size_t n ) {
+  bytebuf_put( &w->out, bytes, n );
+}
+
+static void put_byte( struct pyc_writer *w, unsigned char c ) {
+  bytebuf_put_byte( &w->out, c );
+}
+
+/* Entier de 4 octets, petit-boutiste quelle que soit la machine */
+static void put_int32( struct pyc_writer *w, int32_t value ) {
+  uint32_t v = (uint32_t)value;
+  unsigned char le[ 4 ] = { v & 0xFF, ( v >> 8 ) & 0xFF, ( v >> 16 ) & 0xFF, v >> 24 };
+  put_bytes( w, le, 4 );
+}
+
+static unsigned interned_hash( const char *s, int length ) {
+  unsigned h = 2166136261u;
+  for ( int i = 0 ; i < length ; i++ ) h = ( h ^ (unsigned char)s[ i ] ) * 16777619u;
+  return h;
+}
+
+static struct interned *interned_find( struct pyc_writer *w, const char *s, int length ) {
+  if ( !w->nslots ) return NULL;
+  for ( unsigned i = interned_hash( s, length ) ;; i++ ) {
+    struct interned *slot = &w->interned[ i & ( w->nslots - 1 ) ];
+    if ( !slot->string ) return NULL;
+    if ( slot->length == length && !memcmp( slot->string, s, length ) ) return slot;
+  }
+}
+
+static void interned_add( struct pyc_writer *w, pyobj_t str ) {
+  if ( 2 * ( w->count + 1 ) > w->nslots ) {
+    struct interned *old = w->interned;
+    int nold = w->nslots;
+    w->nslots = w->nslots ? 2 * w->nslots : 64;
+    w->interned = calloc( w->nslots, sizeof( *w->interned ) );
+    assert( w->interned );
+    w->count = 0;
+    for ( int i = 0 ; i < nold ; i++ ) {
+      if ( !old[ i ].string ) continue;
+      for ( unsigned h = interned_hash( old[ i ].string, old[ i ].length ) ;; h++ ) {
+        struct interned *slot = &w->interned[ h & ( w->nslots - 1 ) ];
+        if ( !slot->string ) { *slot = old[ i ]; w->count++; break; }
+      }
+    }
+    free( old );
+  }
+  if ( interned_find( w, str->py.string.buffer, str->py.string.length ) ) return;
+  for ( unsigned h = interned_hash( str->py.string.buffer, str->py.string.length ) ;; h++ ) {
+    struct interned *slot = &w->interned[ h & ( w->nslots - 1 ) ];
+    if ( !slot->string ) {
+      slot->string = str->py.string.buffer;
+      slot->length = str->py.string.length;
+      slot->ref    = -1;
+      w->count++;
+      return;
+    }
+  }
+}
+
+/* Chaînes de .interned du module et des fonctions qui en ont une */
+static void interned_collect( struct pyc_writer *w, pyobj_t code ) {
+  py_codeblock *cb = code->py.codeblock;
+  pyobj_t interned = cb->binary.content.interned;
+  pyobj_t consts   = cb->binary.content.consts;
+
+  for ( int i = 0 ; interned && i < interned->py.list.size ; i++ ) interned_add( w, interned->py.list.value[ i ] );
+  for ( int i = 0 ; consts && i < consts->py.list.size ; i++ ) {
+    if ( consts->py.list.value[ i ] && CODE_MARKER == consts->py.list.value[ i ]->type )
+      interned_collect( w, consts->py.list.value[ i ] );
+  }
+}
+
+static void write_string( struct pyc_writer *w, const char *s, int length, int may_intern ) {
+  struct interned *slot = may_intern ? interned_find( w, s, length ) : NULL;
+
+  if ( slot && slot->ref >= 0 ) {
+    put_byte( w, STRINGREF_MARKER );
+    put_int32( w, slot->ref );
+    return;
+  }
+  if ( slot ) slot->ref = w->refs++;
+  put_byte( w, slot ? INTERNED_MARKER : STRING_MARKER );
+  put_int32( w, length );
+  put_bytes( w, s, length );
+}
+
+/* Bytecode, lnotab : chaînes sans nom, voir en tête du fichier */
+static void write_bytes( struct pyc_writer *w, pyobj_t bytes ) {
+  if ( !bytes ) write_string( w, "", 0, 1 );
+  else write_string( w, bytes->py.string.buffer, bytes->py.string.length, bytes->py.string.length <= 1 );
+}
+
+static void write_object( struct pyc_writer *w, pyobj_t obj );
+
+/* Conteneur, écrit comme un tuple s'il est absent (directive omise) */
+static void write_tuple( struct pyc_writer *w, pyobj_t list ) {
+  put_byte( w, list && LIST_MARKER == list->type ? LIST_MARKER : TUPLE_MARKER );
+  put_int32( w, list ? list->py.list.size : 0 );
+  for ( int i = 0 ; list && i < list->py.list.size ; i++ ) write_object( w, list->py.list.value[ i ] );
+}
+
+static void write_code( struct pyc_writer *w, py_codeblock *cb ) {
+  put_byte( w, CODE_MARKER );
+  put_int32( w, cb->header.arg_count );
+  put_int32( w, cb->header.local_count );
+  put_int32( w, cb->header.stack_size );
+  put_int32( w, cb->header.flags );
+  write_bytes( w, cb->binary.content.bytecode );
+  write_tuple( w, cb->binary.content.consts );
+  write_tuple( w, cb->binary.content.names );
+  write_tuple( w, cb->binary.content.varnames );
+  write_tuple( w, cb->binary.content.freevars );
+  write_tuple( w, cb->binary.content.cellvars );
+  write_object( w, cb->binary.trailer.filename );
+  write_object( w, cb->binary.trailer.name );
+  put_int32( w, cb->binary.trailer.firstlineno );
+  write_bytes( w, cb->binary.trailer.lnotab );
+}
+
+static void write_object( struct pyc_writer *w, pyobj_t obj ) {
+  if ( !obj ) {
+    put_byte( w, NULL_MARKER );
+    return;
+  }
+
+  switch ( obj->type ) {
+  case NONE_MARKER:
+  case TRUE_MARKER:
+  case FALSE_MARKER:
+    put_byte( w, obj->type );
+    break;
+
+  case INT_MARKER:
+    put_byte( w, INT_MARKER );
+    put_int32( w, obj->py.number.integer );
+    break;
+
+  case FLOAT_MARKER: {
+    /* marshal version 2 : le double en binaire, petit-boutiste */
+    unsigned char le[ 8 ];
+    uint64_t bits;
+    memcpy( &bits, &obj->py.number.real, sizeof( bits ) );
+    for ( int i = 0 ; i < 8 ; i++ ) le[ i ] = ( bits >> ( 8 * i ) ) & 0xFF;
+    put_byte( w, BINARY_FLOAT_MARKER );
+    put_bytes( w, le, 8 );
+    break;
+  }
+
+  case STRING_MARKER:
+  case STRINGREF_MARKER:
+    write_string( w, obj->py.string.buffer, obj->py.string.length, 1 );
+    break;
+
+  case TUPLE_MARKER:
+  case LIST_MARKER:
+  case SET_MARKER: /* listes de la directive : un tuple dans le .pyc */
+    write_tuple( w, obj );
+    break;
+
+  case CODE_MARKER:
+    write_code( w, obj->py.codeblock );
+    break;
+
+  default:
+    fprintf( stderr, "Warning: objet de type '%c' écrit comme None.\n", obj->type );
+    put_byte( w, NONE_MARKER );
+    break;
+  }
+}
+
+unsigned char *pyc_marshal( pyobj_t code, time_t timestamp, size_t *size ) {
+  struct pyc_writer w;
+
+  assert( code && CODE_MARKER == code->type && size );
+  memset( &w, 0, sizeof( w ) );
+  bytebuf_init( &w.out, 4096 );
+  interned_collect( &w, code );
+
+  put_int32( &w, PYC_MAGIC( code->py.codeblock->version_pyvm ) );
+  put_int32( &w, (int32_t)timestamp );
+  write_code( &w, code->py.codeblock );
+
+  free( w.interned );
+  return (unsigned char *)bytebuf_release( &w.out, size );
+}
+
+int pyc_write( pyobj_t code, char *filename, time_t timestamp ) {
+  size_t size;
+  unsigned char *data = pyc_marshal( code, timestamp, &size );
+  int fd = open( filename, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  size_t done = 0;
+
+  if ( fd < 0 ) {
+    fprintf( stderr, "Erreur: impossible de créer '%s'.\n", filename );
+    free( data );
+    return -1;
+  }
+  /* Un seul write(), sauf s'il est interrompu avant la fin */
+  while ( done < size ) {
+    ssize_t n = write( fd, data + done, size - done );
+    if ( n <= 0 ) break;
+    done += n;
+  }
+  free( data );
+  if ( close( fd ) || done < size ) {
+    fprintf( stderr, "Erreur: écriture de '%s' incomplète.\n", filename );
+    return -1;
+  }
+  return 0;
+}
@@ -1,11 +1,14 @@
 #include <stdio.h> // Include standard I/O if necessary
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
 #include <pyas/re_match.h>
 #include <pyas/chargroup.h>
 #include <pyas/list.h>
 
 static int re_match_zero_or_more( chargroup_t cg, char **end ) {
-  if (cg->has_negation) {
+  if (chargroup_has_negation(cg)) {
     while (**end != '\0' && !chargroup_has_char(cg, **end)) (*end)++;
   }
   else {
@@ -15,7 +18,7 @@ static int re_match_zero_or_more( chargroup_t cg, char **end ) {
 }
 
 static int re_match_zero_or_one( chargroup_t cg, char **end ) {
-  if (cg->has_negation) {
+  if (chargroup_has_negation(cg)) {
     if (**end != '\0' && !chargroup_has_char(cg, **end)) (*end)++;
   }
   else {
@@ -25,7 +28,7 @@ static int re_match_zero_or_one( chargroup_t cg, char **end ) {
 }
 
 static int re_match_one_or_more( chargroup_t cg, char **end ) {
-  if (cg->has_negation) {
+  if (chargroup_has_negation(cg)) {
     if (chargroup_has_char(cg, **end)) return 0; 
     while (**end != '\0' && !chargroup_has_char(cg, **end)) (*end)++;
     return 1;
@@ -37,6 +40,99 @@ static int re_match_one_or_more( chargroup_t cg, char **end ) {
   }
 }
 
+/*
+  Simulation de l'automate de Thompson de la liste de chargroup.
+  L'état (g, f) signifie "au groupe g", f valant 1 pour un groupe '+'
+  déjà consommé au moins une fois ; il porte le bit 2*g+f. L'état 2*n
+  (après le dernier groupe) est acceptant. On garde un ensemble de bits
+  des états actifs : chaque caractère est lu une seule fois, sans retour
+  arrière, donc le temps est linéaire en la longueur de la source.
+*/
+#define NFA_SMALL 64 // groupes gérés sans allocation
+
+#define BIT_SET( set, i ) ( (set)[ (i) >> 6 ] |= (uint64_t)1 << ( (i) & 63 ) )
+#define BIT_GET( set, i ) ( ( (set)[ (i) >> 6 ] >> ( (i) & 63 ) ) & 1 )
+
+/* Peut-on passer le groupe g sans consommer (état (g, f)) ? */
+static int nfa_skippable( chargroup_t cg, int f ) {
+  return chargroup_has_operator_star(cg) || chargroup_has_operator_question(cg)
+    || ( chargroup_has_operator_plus(cg) && f );
+}
+
+/* Ferme l'ensemble par les transitions vides : elles vont toujours
+   vers un groupe suivant, donc un seul parcours croissant suffit. */
+static void nfa_closure( chargroup_t *groups, int n, uint64_t *set ) {
+  for (int i = 0; i < 2 * n; i++) {
+    if (BIT_GET(set, i) && nfa_skippable(groups[i / 2], i % 2)) BIT_SET(set, 2 * (i / 2 + 1));
+  }
+}
+
+static int re_match_nfa( list_t re, char *source, char **end ) {
+  chargroup_t small_groups[ NFA_SMALL ];
+  uint64_t small_sets[ 2 * ( ( 2 * NFA_SMALL + 1 + 63 ) / 64 ) ];
+  chargroup_t *groups = small_groups;
+  uint64_t *sets = small_sets, *cur, *next;
+  int n = (int)list_length(re);
+  int words = ( 2 * n + 1 + 63 ) / 64;
+  char *last = NULL;
+
+  if (n > NFA_SMALL) {
+    groups = malloc(n * sizeof(*groups));
+    sets = calloc(2 * words, sizeof(*sets));
+    if (!groups || !sets) {
+      fprintf(stderr, "Erreur d'allocation mémoire dans re_match_nfa\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  cur = sets;
+  next = sets + words;
+
+  for (int g = 0; g < n; g++, re = list_next(re)) groups[g] = list_first(re);
+
+  memset(cur, 0, words * sizeof(*cur));
+  BIT_SET(cur, 0);
+  nfa_closure(groups, n, cur);
+  if (BIT_GET(cur, 2 * n)) last = source;
+
+  for (char *p = source; *p != '\0'; p++) {
+    uint64_t alive = 0;
+
+    memset(next, 0, words * sizeof(*next));
+    for (int i = 0; i < 2 * n; i++) {
+      chargroup_t cg;
+      if (!BIT_GET(cur, i)) continue;
+      cg = groups[i / 2];
+      if (chargroup_has_char(cg, *p) == chargroup_has_negation(cg)) continue;
+      if (chargroup_has_operator_star(cg))      BIT_SET(next, i - i % 2);
+      else if (chargroup_has_operator_plus(cg)) BIT_SET(next, i - i % 2 + 1);
+      else                                      BIT_SET(next, 2 * (i / 2 + 1));
+    }
+    nfa_closure(groups, n, next);
+
+    for (int w = 0; w < words; w++) alive |= next[w];
+    if (!alive) break;
+    if (BIT_GET(next, 2 * n)) last = p + 1;
+
+    uint64_t *tmp = cur; cur = next; next = tmp;
+  }
+
+  if (n > NFA_SMALL) {
+    free(groups);
+    free(sets);
+  }
+
+  if (!last) return 0;
+  if (end != NULL) *end = last;
+  return 1;
+}
+
+int re_match_flags(list_t re, char *source, char **end, int flags) {
+  if ((flags & RE_MATCH_NFA) && re && source && list_first(re)) {
+    return re_match_nfa(re, source, end);
+  }
+  return re_match(re, source, end);
+}
+
 int re_match(list_t re, char *source, char **end) {
   if (!re || !source) {
     fprintf(stderr, "re or match is NULL, please check the arguments of re_match");
@@ -63,7 +159,7 @@ int re_match(list_t re, char *source, char **end) {
     } else if (chargroup_has_operator_plus(cg)) {
       matched = re_match_one_or_more(cg, &current);
     } else {
-      if (!cg->has_negation) {
+      if (!chargroup_has_negation(cg)) {
         if (*current != '\0' && chargroup_has_char(cg, *current)) {
           current++;
           matched = 1;
@@ -94,3 +190,67 @@ int re_match(list_t re, char *source, char **end) {
 }
 
 
+
+/* Tranche de re_match_batch traitée par un thread */
+struct re_batch {
+  list_t       re;
+  char       **sources;
+  re_result_t *results;
+  size_t       first, last;
+  int          flags;
+  size_t       matched;
+  int          started; /* thread lancé, à attendre */
+};
+
+static void *re_match_range(void *_batch) {
+  struct re_batch *batch = _batch;
+
+  for (size_t i = batch->first; i < batch->last; i++) {
+    char *end = batch->sources[i];
+    batch->results[i].match = re_match_flags(batch->re, batch->sources[i], &end, batch->flags);
+    batch->results[i].end   = batch->results[i].match ? (size_t)(end - batch->sources[i]) : 0;
+    batch->matched += batch->results[i].match;
+  }
+  return NULL;
+}
+
+size_t re_match_batch(list_t re, char **sources, size_t count, re_result_t *results, int flags, int threads) {
+  struct re_batch *batches;
+  pthread_t *tids;
+  size_t matched = 0;
+
+  if (threads < 1) threads = 1;
+  if ((size_t)threads > count) threads = count ? (int)count : 1;
+
+  batches = calloc(threads, sizeof(*batches));
+  tids = calloc(threads, sizeof(*tids));
+  if (!batches || !tids) {
+    fprintf(stderr, "Erreur d'allocation mémoire dans re_match_batch\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Tranches contiguës de tailles égales à un près */
+  for (int t = 0; t < threads; t++) {
+    batches[t].re      = re;
+    batches[t].sources = sources;
+    batches[t].results = results;
+    batches[t].first   = count * t / threads;
+    batches[t].last    = count * (t + 1) / threads;
+    batches[t].flags   = flags;
+  }
+
+  /* Le thread appelant prend la première tranche */
+  for (int t = 1; t < threads; t++) {
+    batches[t].started = !pthread_create(&tids[t], NULL, re_match_range, &batches[t]);
+    if (!batches[t].started) re_match_range(&batches[t]); // pas de thread disponible : on le fait ici
+  }
+  re_match_range(&batches[0]);
+  for (int t = 1; t < threads; t++) {
+    if (batches[t].started) pthread_join(tids[t], NULL);
+  }
+
+  for (int t = 0; t < threads; t++) matched += batches[t].matched;
+  free(batches);
+  free(tids);
+  return matched;
+}
@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <pyas/list.h>
 #include <pyas/queue.h> 
 #include <pyas/regexp.h>
@@ -17,10 +18,45 @@
 
 
 
+//-----------------------------
+void re_context_init(re_context_t *ctx) {
+    assert(ctx);
+    ctx->prev_type = 0;
+    ctx->error.code = RE_OK;
+    ctx->error.index = -1;
+    ctx->error.message[0] = '\0';
+}
+
+// Enregistre l'erreur dans le contexte (la première seulement) et renvoie -1
+static int re_error(re_context_t *ctx, int code, int idx, const char *format, ...) {
+    va_list ap;
+
+    if (ctx->error.code != RE_OK) return -1;
+    ctx->error.code = code;
+    ctx->error.index = idx;
+    va_start(ap, format);
+    vsnprintf(ctx->error.message, sizeof(ctx->error.message), format, ap);
+    va_end(ap);
+    return -1;
+}
+
 //-----------------------------
 list_t re_read(char* regexp_str) {
+    re_context_t ctx;
+    re_context_init(&ctx);
+
+    list_t re = re_compile(&ctx, regexp_str);
+    if (!re) fprintf(stderr, "%s\n", ctx.error.message);
+    return re;
+}
+
+//-----------------------------
+list_t re_compile(re_context_t *ctx, const char* regexp_str) {
     list_t re = list_new();
 
+    assert(ctx);
+    ctx->prev_type = 0; // l'état ne survit pas d'une regexp à l'autre
+
     if (!regexp_str || *regexp_str == '\0') {
         re = list_add_first(NULL, re);
         return re;
@@ -28,7 +64,7 @@ list_t re_read(char* regexp_str) {
     
     int idx = 0;
     if (regexp_str[idx] == '+' || regexp_str[idx] == '*' || regexp_str[idx] == '?' ) {
-        fprintf(stderr, "Erreur: caractère spécial '%c' comme première caractère, index %d.\n", regexp_str[idx], idx);
+        re_error(ctx, RE_ERR_OPERATOR, idx, "Erreur: caractère spécial '%c' comme première caractère, index %d.", regexp_str[idx], idx);
         list_delete(re, chargroup_delete_cb);
         return NULL;
     }
@@ -38,14 +74,14 @@ list_t re_read(char* regexp_str) {
         chargroup_t cg = chargroup_new();
 
         if (regexp_str[idx] == '\n' || regexp_str[idx] == '\t' ){
-            fprintf(stderr, "Erreur: opérateurs invalides ('\t' ou '\n') à l'index %d.\n", idx);
+            re_error(ctx, RE_ERR_WHITESPACE, idx, "Erreur: opérateurs invalides ('\t' ou '\n') à l'index %d.", idx);
             chargroup_delete(cg);
             list_delete(re, chargroup_delete_cb);
             return NULL;
         }
         // Vérifie s'il y a une mauvaise combinaison d'opérateurs spéciaux
-        if (check_special_operators(regexp_str, idx) != 0) {
-            fprintf(stderr, "Erreur: opérateurs spéciaux consécutifs ou invalides à l'index %d.\n", idx);
+        if (check_special_operators(ctx, regexp_str, idx) != 0) {
+            re_error(ctx, RE_ERR_OPERATOR, idx, "Erreur: opérateurs spéciaux consécutifs ou invalides à l'index %d.", idx);
             chargroup_delete(cg);
             list_delete(re, chargroup_delete_cb);
             return NULL;
@@ -53,10 +89,17 @@ list_t re_read(char* regexp_str) {
 
         // Gestion du '^' éventuel (négation)
         if (regexp_str[idx] == '^') {
-            cg->has_negation = 1;
+            chargroup_set_negation(cg);
             idx++;
             if (regexp_str[idx] == '\0') {
-                fprintf(stderr, "Erreur: '^' en fin de chaîne sans caractère suivant.\n");
+                re_error(ctx, RE_ERR_NEGATION, idx, "Erreur: '^' en fin de chaîne sans caractère suivant.");
+                chargroup_delete(cg);
+                list_delete(re, chargroup_delete_cb);
+                return NULL;
+            }
+            // '^' suivi d'un opérateur ou d'un autre '^'
+            if (check_special_operators(ctx, regexp_str, idx) != 0) {
+                re_error(ctx, RE_ERR_OPERATOR, idx, "Erreur: opérateurs spéciaux consécutifs ou invalides à l'index %d.", idx);
                 chargroup_delete(cg);
                 list_delete(re, chargroup_delete_cb);
                 return NULL;
@@ -66,7 +109,7 @@ list_t re_read(char* regexp_str) {
         // Lecture du bloc : soit un caractère normal, soit '.', soit '[ ]', soit une séquence échappée
         if (regexp_str[idx] == '\\') {
             // parse_escape_sequence
-            if (parse_escape_sequence(regexp_str, &idx, cg) != 0) {
+            if (parse_escape_sequence(ctx, regexp_str, &idx, cg) != 0) {
                 chargroup_delete(cg);
                 list_delete(re, chargroup_delete_cb);
                 return NULL;
@@ -79,14 +122,14 @@ list_t re_read(char* regexp_str) {
         }
         else if (regexp_str[idx] == '[') {
             // parse_char_class
-            if (parse_char_class(regexp_str, &idx, cg) != 0) {
+            if (parse_char_class(ctx, regexp_str, &idx, cg) != 0) {
                 chargroup_delete(cg);
                 list_delete(re, chargroup_delete_cb);
                 return NULL;
             }
         }
         else if(regexp_str[idx] == ']'){
-                fprintf(stderr, "Erreur: ']' avant '[' à l'index %d.\n", idx);
+                re_error(ctx, RE_ERR_CLASS, idx, "Erreur: ']' avant '[' à l'index %d.", idx);
                 chargroup_delete(cg);
                 list_delete(re, chargroup_delete_cb);
                 return NULL;
@@ -100,7 +143,8 @@ list_t re_read(char* regexp_str) {
         // Vérifie si le caractère suivant est un opérateur (*, +, ?)
         // parse_operator ne renvoie pas d'erreur, 
         // mais s'il le fallait, on pourrait la gérer.
-        parse_operator(regexp_str, &idx, cg);
+        // Le groupe suivant doit savoir si le caractère précédent était un opérateur.
+        ctx->prev_type = parse_operator(regexp_str, &idx, cg) ? 1 : 0;
 
         // Ajoute le groupe à la liste
         re = list_add_last(re, cg);
@@ -109,46 +153,45 @@ list_t re_read(char* regexp_str) {
     return re;
 }
 //-----------------------------
-int check_special_operators(const char* regexp_str, int idx) {
+int check_special_operators(re_context_t *ctx, const char* regexp_str, int idx) {
     /*
+      ctx->prev_type :
       0 = aucun
       1 = opérateur (+, *, ?)
       2 = '^'
     */
-    static int prev_type = 0;
-
     char current = regexp_str[idx];
 
     // On traite d’abord le cas des opérateurs +, * ou ?
     if (current == '+' || current == '*' || current == '?') {
         // Si le précédent était un opérateur (1), c'est un 2e opérateur de suite => erreur
         // Si le précédent était '^' (2), alors '^' est suivi d'un opérateur => erreur
-        if (prev_type == 1 || prev_type == 2) {
+        if (ctx->prev_type == 1 || ctx->prev_type == 2) {
             return -1;
         }
         // Sinon, on accepte => on met prev_type = 1
-        prev_type = 1;
+        ctx->prev_type = 1;
     }
     // Ensuite, le cas du '^'
     else if (current == '^') {
         // Si le précédent était '^' => erreur (^^)
         // Si le précédent était un opérateur => on autorise (ex: *^)
-        if (prev_type == 2) {
+        if (ctx->prev_type == 2) {
             return -1;
         }
         // On met prev_type = 2
-        prev_type = 2;
+        ctx->prev_type = 2;
     }
     // Sinon, c'est un caractère normal
     else {
-        prev_type = 0;
+        ctx->prev_type = 0;
     }
 
     return 0; // Pas d'erreur
 }
 
 //-----------------------------
-int parse_char_class(const char* regexp_str, int* idx_ptr, chargroup_t cg) {
+int parse_char_class(re_context_t *ctx, const char* regexp_str, int* idx_ptr, chargroup_t cg) {
     /*
       Parse jusqu'à la fermeture ']', gère les intervalles x-y,
       refuse +, *, ?, ^ s'ils ne sont pas échappés,
@@ -158,34 +201,28 @@ int parse_char_class(const char* regexp_str, int* idx_ptr, chargroup_t cg) {
 
     idx++; // passer le '['
     if (regexp_str[idx] == '\0') {
-        fprintf(stderr, "Erreur: '[' non fermé (fin de chaîne atteinte)\n");
-        return -1;
+        return re_error(ctx, RE_ERR_CLASS, idx, "Erreur: '[' non fermé (fin de chaîne atteinte)");
     }
     if(regexp_str[idx] == ']'){
-        fprintf(stderr, "Erreur: aucune information entre les crochets '[]'\n");
-        return -1;
+        return re_error(ctx, RE_ERR_CLASS, idx, "Erreur: aucune information entre les crochets '[]'");
     }
     if(regexp_str[idx] == '-'){
-        fprintf(stderr, "Erreur: aucuns caractères avant le tiret '[ -...]'\n");
-        return -1;
+        return re_error(ctx, RE_ERR_CLASS, idx, "Erreur: aucuns caractères avant le tiret '[ -...]'");
     }
 
     while (regexp_str[idx] != ']') {
         if (regexp_str[idx] == '\0') {
-            fprintf(stderr, "Erreur: ']' manquant pour fermer la classe de caractères.\n");
-            return -1;
+            return re_error(ctx, RE_ERR_CLASS, idx, "Erreur: ']' manquant pour fermer la classe de caractères.");
         }
         if (regexp_str[idx] == '\n' || regexp_str[idx] == '\t' ){
-            fprintf(stderr, "Erreur: opérateurs invalides ('\t' ou '\n') dans '[...]'.\n");
-            return -1;
+            return re_error(ctx, RE_ERR_WHITESPACE, idx, "Erreur: opérateurs invalides ('\t' ou '\n') dans '[...]'.");
         }
 
         // Si on a un backslash => on considère le caractère qui suit comme littéral
         if (regexp_str[idx] == '\\') {
             idx++;
             if (regexp_str[idx] == '\0') {
-                fprintf(stderr, "Erreur: '\\' sans caractere suivant à l'index %d\n", idx);
-                return -1;
+                return re_error(ctx, RE_ERR_ESCAPE, idx, "Erreur: '\\' sans caractere suivant à l'index %d", idx);
             }
             if (regexp_str[idx] == 'n')
                 chargroup_add_char(cg, '\n');
@@ -203,24 +240,21 @@ int parse_char_class(const char* regexp_str, int* idx_ptr, chargroup_t cg) {
         // et un 3e caractère après différent de ']' et != '\0'.
         if (regexp_str[idx + 1] == '-' && regexp_str[idx + 2] != '\0'){
             if(regexp_str[idx + 2] == ']'){
-                fprintf(stderr, "Erreur: aucuns caractères apres le tiret '[... - ]'\n");
-                return -1;
+                return re_error(ctx, RE_ERR_CLASS, idx, "Erreur: aucuns caractères apres le tiret '[... - ]'");
             }
             char start = regexp_str[idx];
             char end = regexp_str[idx + 2];
 
             // On ajoute tous les chars de [start..end]
             if (start > end) {
-                fprintf(stderr, "Erreur: intervalle inversé '%c-%c' à l'index %d.\n", start, end, idx);
-                return -1;
+                return re_error(ctx, RE_ERR_CLASS, idx, "Erreur: intervalle inversé '%c-%c' à l'index %d.", start, end, idx);
             }
             for (int c = start; c <= end; c++) {
                 chargroup_add_char(cg, (unsigned char)c);
             }
             idx += 2; 
             if(regexp_str[idx-1] =='-' && regexp_str[idx+1] =='-'){ //traite les cas comme [a-b-z]
-                fprintf(stderr, "Erreur: 'trop de '-' à l'index %d\n", idx);
-                return -1; 
+                return re_error(ctx, RE_ERR_CLASS, idx, "Erreur: 'trop de '-' à l'index %d", idx);
             }
             idx++; // On a consommé start, '-', end
             continue;
@@ -228,8 +262,7 @@ int parse_char_class(const char* regexp_str, int* idx_ptr, chargroup_t cg) {
 
         // Si c'est un caractère spécial +, *, ?, ^ NON échappé => erreur
         if (regexp_str[idx] == '+' || regexp_str[idx] == '*' || regexp_str[idx] == '?' || regexp_str[idx] == '^' || regexp_str[idx] == '[' || regexp_str[idx] == '.' ) {
-            fprintf(stderr, "Erreur: caractère '%c' qui n'ont pas lieu d'etre dans '[]' (non échappe), index %d.\n", regexp_str[idx], idx);
-            return -1;
+            return re_error(ctx, RE_ERR_CLASS, idx, "Erreur: caractère '%c' qui n'ont pas lieu d'etre dans '[]' (non échappe), index %d.", regexp_str[idx], idx);
         }
 
         // Sinon, on ajoute le caractère normalement
@@ -243,15 +276,14 @@ int parse_char_class(const char* regexp_str, int* idx_ptr, chargroup_t cg) {
 }
 
 //-----------------------------
-int parse_escape_sequence(const char* regexp_str, int* idx_ptr, chargroup_t cg) {
+int parse_escape_sequence(re_context_t *ctx, const char* regexp_str, int* idx_ptr, chargroup_t cg) {
     /*
       Gère \n, \t, et sinon ajoute le caractère littéral.
     */
     int idx = *idx_ptr;
 
     if (regexp_str[idx + 1] == '\0') {
-        fprintf(stderr, "Erreur: '\\' sans caractère suivant à l'index %d\n", idx);
-        return -1;
+        return re_error(ctx, RE_ERR_ESCAPE, idx, "Erreur: '\\' sans caractère suivant à l'index %d", idx);
     }
 
     idx++; // Passer le '\'